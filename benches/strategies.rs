@@ -0,0 +1,248 @@
+//! Strategy comparison benchmark.
+//!
+//! Backs the performance table in README.md with something reproducible:
+//! generates a synthetic tree with a configurable file-size distribution,
+//! then runs each warming strategy in `warming::` at several queue depths,
+//! dropping the page cache between runs so every pass starts cold. Meant to
+//! be run on a scratch EBS volume in staging before a version bump; on a
+//! developer machine the numbers only show relative ordering.
+//!
+//! ```bash
+//! cargo bench --bench strategies
+//! BENCH_DIR=/mnt/scratch/bench BENCH_PROFILE=bimodal BENCH_DEPTHS=32,128,512 \
+//!     cargo bench --bench strategies
+//! ```
+//!
+//! `BENCH_PROFILE`:
+//!   quick   - 512 x 64KB + 8 x 16MB (default; fits in /tmp)
+//!   bimodal - 2000 x 2KB + 2 x 2GB (our production shape; needs ~4GB scratch)
+
+use std::fs;
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::time::Instant;
+
+use futures::stream::{self, StreamExt};
+
+use rust_cache_warmer::warming::{self, WarmingOptions};
+
+/// (files, bytes each) pairs making up one synthetic tree.
+type Distribution = &'static [(usize, u64)];
+
+const QUICK: Distribution = &[(512, 64 * 1024), (8, 16 * 1024 * 1024)];
+const BIMODAL: Distribution = &[(2000, 2 * 1024), (2, 2 * 1024 * 1024 * 1024)];
+
+fn main() {
+    let dir = std::env::var("BENCH_DIR")
+        .map(PathBuf::from)
+        .unwrap_or_else(|_| std::env::temp_dir().join("warmer-bench"));
+    let distribution = match std::env::var("BENCH_PROFILE").as_deref() {
+        Ok("bimodal") => BIMODAL,
+        _ => QUICK,
+    };
+    let depths: Vec<usize> = std::env::var("BENCH_DEPTHS")
+        .unwrap_or_else(|_| "32,128,512".to_string())
+        .split(',')
+        .filter_map(|d| d.trim().parse().ok())
+        .collect();
+
+    let files = generate_tree(&dir, distribution).expect("failed to generate benchmark tree");
+    let total_bytes: u64 = files.iter().map(|(_, size)| size).sum();
+    println!(
+        "🔥 Benchmark tree: {} files, {:.1} MB at {}",
+        files.len(),
+        total_bytes as f64 / 1_048_576.0,
+        dir.display()
+    );
+
+    let mut baseline_mb_s = None;
+    println!();
+    println!("| Strategy    | Depth | Elapsed    | MB/s      | Relative | Errors |");
+    println!("|-------------|-------|------------|-----------|----------|--------|");
+    for &depth in &depths {
+        for (name, options, driver) in strategies(depth) {
+            drop_caches(&files);
+            let start = Instant::now();
+            let errors = run_strategy(&files, depth, &options, driver);
+            let elapsed = start.elapsed();
+            let mb_s = total_bytes as f64 / 1_048_576.0 / elapsed.as_secs_f64();
+            let baseline = *baseline_mb_s.get_or_insert(mb_s);
+            println!(
+                "| {:<11} | {:>5} | {:>8.2}ms | {:>9.1} | {:>7.2}x | {:>6} |",
+                name,
+                depth,
+                elapsed.as_secs_f64() * 1000.0,
+                mb_s,
+                mb_s / baseline,
+                errors
+            );
+        }
+    }
+}
+
+/// How a row's files get warmed. The cascade in `warming::warm_file` tries
+/// os_hints before the plain direct-I/O reader, so the direct_io row calls
+/// that reader directly - otherwise it would just measure fadvise again.
+#[derive(Clone, Copy)]
+enum Driver {
+    Cascade,
+    DirectReader,
+}
+
+/// The strategy matrix: one WarmingOptions per row of the README table,
+/// plus the auto selector. Linux-only strategies are cfg'd out elsewhere.
+fn strategies(depth: usize) -> Vec<(&'static str, WarmingOptions, Driver)> {
+    let base = WarmingOptions {
+        use_io_uring: false,
+        use_libaio: false,
+        use_direct_io: false,
+        sparse_large_files: 0,
+        queue_depth: depth,
+        auto_strategy: false,
+        small_file_threshold: 65536,
+        huge_file_threshold: 104_857_600,
+        range_parallel_threshold: 0,
+        skip_resident: false,
+        sparse_read_size: 4096,
+        sparse_stride: 524_288,
+        #[cfg(target_os = "linux")]
+        uring_engine: None,
+        #[cfg(target_os = "linux")]
+        cache_dropper: None,
+    };
+
+    let mut matrix = vec![("os_hints", base.clone(), Driver::Cascade)];
+    matrix.push((
+        "direct_io",
+        WarmingOptions { use_direct_io: true, ..base.clone() },
+        Driver::DirectReader,
+    ));
+    #[cfg(target_os = "linux")]
+    {
+        matrix.push((
+            "libaio",
+            WarmingOptions { use_libaio: true, use_direct_io: true, ..base.clone() },
+            Driver::Cascade,
+        ));
+        // Route the io_uring row through a real shared engine - the same
+        // path the binary takes - since buffered io_uring without one is
+        // Unsupported and would silently fall through to fadvise.
+        match warming::engine::UringEngine::new(depth, None) {
+            Ok(engine) => matrix.push((
+                "io_uring",
+                WarmingOptions {
+                    use_io_uring: true,
+                    uring_engine: Some(engine),
+                    ..base.clone()
+                },
+                Driver::Cascade,
+            )),
+            Err(e) => eprintln!("skipping io_uring row: {}", e),
+        }
+    }
+    matrix.push(("auto", WarmingOptions { auto_strategy: true, ..base }, Driver::Cascade));
+    matrix
+}
+
+/// Warm every file, mirroring the binary's single file-level concurrency
+/// limiter. Returns the error count.
+fn run_strategy(
+    files: &[(PathBuf, u64)],
+    depth: usize,
+    options: &WarmingOptions,
+    driver: Driver,
+) -> u64 {
+    let runtime = tokio::runtime::Runtime::new().expect("failed to build tokio runtime");
+    runtime.block_on(async {
+        let errors = std::sync::atomic::AtomicU64::new(0);
+        stream::iter(files)
+            .for_each_concurrent(depth, |(path, size)| {
+                let errors = &errors;
+                async move {
+                    let result = match driver {
+                        Driver::Cascade => warming::warm_file(path, *size, options).await,
+                        Driver::DirectReader => {
+                            warming::tokio_async::warm_file(path, *size, options).await
+                        }
+                    };
+                    match result {
+                        Ok(result) if result.success => {}
+                        _ => {
+                            errors.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+                        }
+                    }
+                }
+            })
+            .await;
+        errors.into_inner()
+    })
+}
+
+/// Build the synthetic tree, reusing it when the previous run left an
+/// identical layout behind (the marker records the distribution).
+fn generate_tree(dir: &Path, distribution: Distribution) -> std::io::Result<Vec<(PathBuf, u64)>> {
+    let marker = dir.join(".bench-layout");
+    let layout = format!("{:?}", distribution);
+    if fs::read_to_string(&marker).map(|m| m == layout).unwrap_or(false) {
+        return collect_tree(dir, distribution);
+    }
+    if dir.exists() {
+        fs::remove_dir_all(dir)?;
+    }
+    fs::create_dir_all(dir)?;
+
+    // Non-zero patterned data so every block is a real allocated extent;
+    // all-zero files can end up as holes on some filesystems.
+    let chunk = vec![0xA5u8; 1 << 20];
+    for (class, &(count, size)) in distribution.iter().enumerate() {
+        let class_dir = dir.join(format!("class-{}", class));
+        fs::create_dir_all(&class_dir)?;
+        for i in 0..count {
+            let mut file = fs::File::create(class_dir.join(format!("f{:06}", i)))?;
+            let mut remaining = size;
+            while remaining > 0 {
+                let n = remaining.min(chunk.len() as u64) as usize;
+                file.write_all(&chunk[..n])?;
+                remaining -= n as u64;
+            }
+        }
+    }
+    fs::write(&marker, layout)?;
+    collect_tree(dir, distribution)
+}
+
+fn collect_tree(dir: &Path, distribution: Distribution) -> std::io::Result<Vec<(PathBuf, u64)>> {
+    let mut files = Vec::new();
+    for (class, &(count, size)) in distribution.iter().enumerate() {
+        for i in 0..count {
+            files.push((dir.join(format!("class-{}", class)).join(format!("f{:06}", i)), size));
+        }
+    }
+    Ok(files)
+}
+
+/// Evict the tree from the page cache so the next run starts cold. The
+/// per-file DONTNEED works unprivileged; the drop_caches write is a
+/// best-effort extra that also clears dentries/inodes when run as root.
+fn drop_caches(files: &[(PathBuf, u64)]) {
+    #[cfg(target_os = "linux")]
+    {
+        unsafe { libc::sync() };
+        for (path, size) in files {
+            if let Ok(file) = fs::File::open(path) {
+                use std::os::unix::io::AsRawFd;
+                unsafe {
+                    libc::posix_fadvise(
+                        file.as_raw_fd(),
+                        0,
+                        *size as libc::off_t,
+                        libc::POSIX_FADV_DONTNEED,
+                    );
+                }
+            }
+        }
+        let _ = fs::write("/proc/sys/vm/drop_caches", "1");
+    }
+    #[cfg(not(target_os = "linux"))]
+    let _ = files;
+}
@@ -0,0 +1,8 @@
+//! Library surface for the cache warmer.
+//!
+//! The binary in `main.rs` owns the CLI, discovery pipeline, and progress
+//! reporting; everything that actually touches blocks lives in [`warming`]
+//! and is exposed here so the benchmark suite (and any embedding tool) can
+//! drive the strategies directly without shelling out to the binary.
+
+pub mod warming;
@@ -8,11 +8,259 @@ use std::sync::atomic::{AtomicU64, Ordering};
 use std::sync::Arc;
 use log::{debug, info, warn};
 use std::time::{Instant, Duration};
-use tokio::sync::{Semaphore, mpsc};
+use tokio::sync::mpsc;
 
-mod warming;
+use rust_cache_warmer::warming;
 use warming::{WarmingOptions, warm_file};
 
+/// A discovered file with the metadata the walker already had, so the
+/// warming loop doesn't need its own statx round trip per file.
+#[derive(Debug, Clone)]
+struct FileEntry {
+    path: PathBuf,
+    size: u64,
+    /// Modification time in seconds, for --warm-order mtime. Carried from
+    /// discovery's batched statx so the sort never re-stats (a 50ms cold
+    /// inode fetch per file); 0 when unknown.
+    mtime: i64,
+    /// Checkpoint identity, populated when --checkpoint, --emit-manifest,
+    /// or --since is active.
+    key: Option<warming::checkpoint::FileKey>,
+    /// With --since, the offset the previous manifest already covers: the
+    /// file only grew, so warming starts here instead of at zero.
+    tail_start: Option<u64>,
+}
+
+/// Per-walker-thread batching for discovery results. Flushes a batch to the
+/// bounded channel when full (blocking the walker thread when warming is
+/// behind - that backpressure is what keeps discovery from ballooning RSS),
+/// and flushes the remainder on drop so no files are lost when a walker
+/// thread finishes. Batches are moved into the channel, never cloned.
+struct BatchSender {
+    batch: Vec<FileEntry>,
+    tx: mpsc::Sender<Vec<FileEntry>>,
+    capacity: usize,
+}
+
+impl BatchSender {
+    fn new(tx: mpsc::Sender<Vec<FileEntry>>, capacity: usize) -> Self {
+        BatchSender { batch: Vec::with_capacity(capacity), tx, capacity }
+    }
+
+    /// Returns false when the receiver is gone and discovery should stop.
+    fn push(&mut self, entry: FileEntry) -> bool {
+        self.batch.push(entry);
+        if self.batch.len() >= self.capacity {
+            let full = std::mem::replace(&mut self.batch, Vec::with_capacity(self.capacity));
+            return self.tx.blocking_send(full).is_ok();
+        }
+        true
+    }
+}
+
+impl Drop for BatchSender {
+    fn drop(&mut self) {
+        if !self.batch.is_empty() {
+            let _ = self.tx.blocking_send(std::mem::take(&mut self.batch));
+        }
+    }
+}
+
+/// How many paths a walker thread gathers before one batched statx submit.
+const STAT_BATCH: usize = 64;
+
+/// Per-walker-thread discovery sink. The walker's dirent tells us "regular
+/// file" without a stat; everything downstream (size, shard hash, hardlink
+/// dedup, checkpoint key) needs real metadata, and on a cold volume each
+/// stat is a synchronous inode fetch from S3. The sink buffers paths and
+/// stats a whole batch at once through `statx::StatBatcher`, so those inode
+/// reads overlap instead of serializing, then runs the usual filter chain
+/// on the results. Dropping the sink flushes the final partial batch, the
+/// same contract as BatchSender.
+struct StatSink<'a> {
+    pending: Vec<PathBuf>,
+    stats: warming::statx::StatBatcher,
+    batch: BatchSender,
+    priority_batch: BatchSender,
+    shard: Option<(u64, u64)>,
+    manifest: Option<Arc<PriorityManifest>>,
+    since: Option<Arc<warming::manifest::Manifest>>,
+    /// With --emit-manifest, unchanged-skipped files are recorded here so
+    /// their coverage carries into the next manifest.
+    manifest_writer: Option<Arc<warming::manifest::ManifestWriter>>,
+    completed: Option<Arc<std::collections::HashSet<warming::checkpoint::FileKey>>>,
+    need_key: bool,
+    file_count: &'a AtomicU64,
+    skipped_count: &'a AtomicU64,
+    unchanged_skipped: &'a AtomicU64,
+    #[cfg(unix)]
+    seen_inodes: &'a std::sync::Mutex<std::collections::HashSet<(u64, u64)>>,
+    #[cfg(unix)]
+    hardlink_skipped: &'a AtomicU64,
+    stopped: bool,
+}
+
+impl StatSink<'_> {
+    /// Returns false when a receiver is gone and discovery should stop.
+    fn accept(&mut self, path: PathBuf) -> bool {
+        self.pending.push(path);
+        if self.pending.len() >= STAT_BATCH {
+            self.flush();
+        }
+        !self.stopped
+    }
+
+    fn flush(&mut self) {
+        if self.stopped || self.pending.is_empty() {
+            return;
+        }
+        let paths = std::mem::replace(&mut self.pending, Vec::with_capacity(STAT_BATCH));
+        let metas = self.stats.stat_many(&paths);
+        for (path, meta) in paths.into_iter().zip(metas) {
+            let meta = match meta {
+                Ok(meta) => meta,
+                Err(e) => {
+                    debug!("Failed to get metadata for {}: {}", path.display(), e);
+                    continue;
+                }
+            };
+            // The dirent said regular file; statx re-checks in case the
+            // entry changed underneath the walk.
+            if !meta.is_file {
+                continue;
+            }
+            // Shard partition: hash-based, so sibling nodes skip this file
+            // without talking to us.
+            if let Some(shard) = self.shard {
+                if !in_shard(&meta, &path, shard) {
+                    continue;
+                }
+            }
+            // Another link to an inode we already queued: same physical
+            // blocks, skip it.
+            #[cfg(unix)]
+            {
+                if meta.nlink > 1
+                    && !self.seen_inodes.lock().unwrap().insert((meta.dev, meta.ino))
+                {
+                    self.hardlink_skipped.fetch_add(1, Ordering::Relaxed);
+                    continue;
+                }
+            }
+            // Checkpoint resume: skip files a previous run already finished
+            // (same dev+inode and unchanged size+mtime).
+            let key = self.need_key.then(|| meta.key());
+            if let (Some(set), Some(key)) = (self.completed.as_deref(), key) {
+                if set.contains(&key) {
+                    self.skipped_count.fetch_add(1, Ordering::Relaxed);
+                    continue;
+                }
+            }
+            // Manifest diff: the previous run already hydrated this file
+            // unless it changed.
+            let mut tail_start = None;
+            if let (Some(since), Some(key)) = (self.since.as_deref(), key.as_ref()) {
+                match since.diff(key) {
+                    warming::manifest::Diff::Unchanged => {
+                        // Still hydrated from the previous run: skip the
+                        // warm but carry the entry into the next manifest.
+                        if let Some(writer) = &self.manifest_writer {
+                            writer.record(*key);
+                        }
+                        self.unchanged_skipped.fetch_add(1, Ordering::Relaxed);
+                        continue;
+                    }
+                    warming::manifest::Diff::Grown { from } => tail_start = Some(from),
+                    warming::manifest::Diff::Changed => {}
+                }
+            }
+            if let Some(manifest) = self.manifest.as_deref() {
+                // Literals were already dispatched ahead of the walk; don't
+                // warm them twice.
+                if manifest.literal_set.contains(&path) {
+                    continue;
+                }
+                if manifest.matches(&path) {
+                    self.file_count.fetch_add(1, Ordering::Relaxed);
+                    if !self.priority_batch.push(FileEntry { path, size: meta.size, mtime: meta.mtime, key, tail_start }) {
+                        self.stopped = true;
+                        return;
+                    }
+                    continue;
+                }
+            }
+            self.file_count.fetch_add(1, Ordering::Relaxed);
+            if !self.batch.push(FileEntry { path, size: meta.size, mtime: meta.mtime, key, tail_start }) {
+                self.stopped = true;
+                return;
+            }
+        }
+    }
+}
+
+impl Drop for StatSink<'_> {
+    fn drop(&mut self) {
+        self.flush();
+    }
+}
+
+/// Paths and globs from --priority-file, split so literal paths can be
+/// warmed immediately without waiting for the walk to reach them.
+struct PriorityManifest {
+    literals: Vec<PathBuf>,
+    literal_set: std::collections::HashSet<PathBuf>,
+    globs: Option<globset::GlobSet>,
+}
+
+impl PriorityManifest {
+    fn load(path: &PathBuf) -> Result<Self> {
+        let content = std::fs::read_to_string(path)?;
+        let mut literals = Vec::new();
+        let mut builder = globset::GlobSetBuilder::new();
+        let mut has_globs = false;
+        for line in content.lines() {
+            let line = line.trim();
+            if line.is_empty() || line.starts_with('#') {
+                continue;
+            }
+            if line.contains(['*', '?', '[', '{']) {
+                builder.add(globset::Glob::new(line)?);
+                has_globs = true;
+            } else {
+                literals.push(PathBuf::from(line));
+            }
+        }
+        let literal_set = literals.iter().cloned().collect();
+        let globs = if has_globs { Some(builder.build()?) } else { None };
+        Ok(PriorityManifest { literals, literal_set, globs })
+    }
+
+    /// Does a walked path belong in the priority lane?
+    fn matches(&self, path: &std::path::Path) -> bool {
+        self.globs.as_ref().map_or(false, |set| set.is_match(path))
+    }
+}
+
+/// Fallback ordering heuristic for --warm-order: which files go first when
+/// no access-frequency manifest is available.
+#[derive(clap::ValueEnum, Clone, Copy, Debug, PartialEq)]
+enum WarmOrder {
+    /// Most recently modified first - recency approximates the hot set.
+    Mtime,
+    /// Smallest first - ramps warmed-file count fastest.
+    Size,
+}
+
+/// How warming work is executed across cores.
+#[derive(clap::ValueEnum, Clone, Copy, Debug, PartialEq)]
+enum EngineMode {
+    /// Multi-threaded tokio runtime with work stealing (the historical mode).
+    Default,
+    /// One tokio-uring runtime per core; files sharded across cores by path
+    /// hash, no cross-core synchronization on the per-file hot path.
+    ThreadPerCore,
+}
+
 #[derive(Parser, Debug)]
 #[clap(
     name = "rust-cache-warmer",
@@ -37,12 +285,29 @@ struct Opts {
     threads: Option<usize>,
 
     #[clap(
-        required = true,
+        required_unless_present_any = ["device", "merge_checkpoints", "files_from"],
         help = "One or more directory paths to warm.",
         num_args = 1..
     )]
     directories: Vec<PathBuf>,
 
+    #[clap(
+        long,
+        value_name = "DEVICE",
+        conflicts_with = "directories",
+        help = "Warm a raw block device (e.g. /dev/nvme1n1) directly, bypassing filesystem discovery. Touches every EBS block with large aligned O_DIRECT reads."
+    )]
+    device: Option<PathBuf>,
+
+    #[clap(
+        long,
+        value_name = "START-END",
+        requires = "device",
+        value_parser = warming::device::parse_range,
+        help = "Byte range of the device to warm, e.g. 0-1073741824. Defaults to the whole device."
+    )]
+    range: Option<(u64, u64)>,
+
     #[clap(long, help = "Follow symbolic links.")]
     follow_symlinks: bool,
 
@@ -85,12 +350,245 @@ struct Opts {
 
     #[clap(long, help = "Use Linux AIO (libaio) for high-performance async I/O. More widely supported than io_uring but slightly lower performance.")]
     libaio: bool,
+
+    #[clap(long, help = "Sort files by physical on-disk address (FIEMAP) before warming so the device sees near-sequential reads. Buffers discovery results before warming starts.")]
+    physical_order: bool,
+
+    #[clap(long, help = "Pick a warming strategy per file by size class: batched ring reads for small files, OS hints for medium, sparse direct I/O for huge.")]
+    auto_strategy: bool,
+
+    #[clap(long, default_value = "65536", help = "With --auto-strategy, files at or below this size in bytes use the batched ring path.")]
+    small_file_threshold: u64,
+
+    #[clap(long, default_value = "104857600", help = "With --auto-strategy, files at or above this size in bytes use sparse direct I/O (0 disables).")]
+    huge_file_threshold: u64,
+
+    #[clap(long, default_value = "1073741824", help = "Split files at or above this size in bytes into ranges warmed in parallel, so one huge file can fill the queue depth by itself (0 disables).")]
+    range_parallel_threshold: u64,
+
+    #[clap(long, help = "Continuously adjust in-flight operations from observed read latency (AIMD) instead of a fixed queue depth. --queue-depth becomes the ceiling.")]
+    adaptive_depth: bool,
+
+    #[clap(long, default_value = "0", value_name = "MB_PER_SEC", help = "Cap warming bandwidth in MB/s so production traffic on the same volume keeps its throughput (0 means unlimited).")]
+    max_bandwidth: u64,
+
+    #[clap(long, default_value = "0", value_name = "OPS_PER_SEC", help = "Cap warming read operations per second to stay under the volume's IOPS budget (0 means unlimited).")]
+    max_iops: u64,
+
+    #[clap(long, value_name = "FILE", help = "Append completed files to this checkpoint log and skip them on the next run, so an interrupted warm resumes where it left off.")]
+    checkpoint: Option<PathBuf>,
+
+    #[clap(long, help = "Probe sampled offsets with preadv2(RWF_NOWAIT) and skip files already resident in the page cache. Makes re-warms over mostly-hydrated data near-instant.")]
+    skip_resident: bool,
+
+    #[clap(long, default_value = "4096", value_name = "BYTES", help = "Bytes read at each sparse sample point. Rounded up to 4KB for O_DIRECT alignment.")]
+    sparse_read_size: usize,
+
+    #[clap(long, default_value = "524288", value_name = "BYTES", help = "Distance between sparse sample points. The 512KiB default matches the EBS snapshot block size: one read per snapshot block hydrates the whole block.")]
+    sparse_stride: u64,
+
+    #[clap(long, value_enum, default_value = "default", help = "Execution engine. thread-per-core runs one tokio-uring runtime per core with files sharded by path hash - best for trees dominated by tiny files. Bypasses --adaptive-depth and --max-bandwidth, and does not support --emit-manifest, --metrics-json/--metrics-prometheus, --warm-order, --physical-order, or --skip-resident.")]
+    engine: EngineMode,
+
+    #[clap(long, value_name = "MANIFEST", help = "File of paths/globs (one per line, # comments) to warm first at full queue depth, before the general walk. Paths must match discovery output textually; generate from production access logs for best time-to-first-useful.")]
+    priority_file: Option<PathBuf>,
+
+    #[clap(long, value_enum, conflicts_with = "physical_order", help = "Heuristic warming order when no access manifest exists: mtime (newest first) or size (smallest first). Buffers discovery results before warming starts, like --physical-order.")]
+    warm_order: Option<WarmOrder>,
+
+    #[clap(long, value_name = "FILE", help = "Write per-strategy counts, latency histograms, and a bytes/IOPS timeline as JSON when the run finishes.")]
+    metrics_json: Option<PathBuf>,
+
+    #[clap(long, value_name = "FILE", help = "Write the same metrics in Prometheus textfile-collector format for node_exporter pickup.")]
+    metrics_prometheus: Option<PathBuf>,
+
+    #[clap(long, value_name = "I/N", value_parser = parse_shard, help = "Warm only shard I of N (e.g. 0/4): files are partitioned by a stable hash of the inode, so N invocations over the same tree split the work deterministically with zero coordination. Every node must use the same N (only I differs) or files fall between shards. Intended for EBS Multi-Attach volumes warmed from several instances.")]
+    shard: Option<(u64, u64)>,
+
+    #[clap(long, value_name = "FILE", num_args = 1.., requires = "checkpoint", conflicts_with = "directories", help = "Coordinator mode: merge the given per-shard checkpoint logs into --checkpoint (deduplicated) and exit, so a follow-up single-node run resumes from the union.")]
+    merge_checkpoints: Option<Vec<PathBuf>>,
+
+    #[clap(long, help = "After warming, sample random offsets in every warmed file with timed O_DIRECT reads, report the latency distribution, and re-warm files whose samples exceed --verify-threshold-us (blocks still backed by S3).")]
+    verify: bool,
+
+    #[clap(long, default_value = "4", value_name = "N", requires = "verify", help = "Verification samples per file.")]
+    verify_samples: u32,
+
+    #[clap(long, default_value = "10000", value_name = "MICROS", requires = "verify", help = "Verification samples slower than this are treated as cold. Hydrated gp3 reads sit around 1ms; a cold block is an S3 round trip well above 10ms.")]
+    verify_threshold_us: u64,
+
+    #[clap(long, help = "Low-impact mode for warming next to a production workload: every warming thread (including the blocking pool) runs in the idle I/O scheduling class so the kernel preempts warming reads the moment production issues its own, and the aligned buffer pool shrinks to a few slots. Combine with --max-bandwidth for a hard cap.")]
+    background: bool,
+
+    #[clap(long, value_name = "CPUS", value_parser = parse_cpu_set, help = "Pin all warming threads to these CPUs (e.g. 2-3,6) and size the runtime to match, keeping the rest of the instance free for production.")]
+    cpu_set: Option<CpuSet>,
+
+    #[clap(long, value_name = "FILE", help = "After the run, write a warm manifest: one compact binary record (dev, inode, size, mtime) per successfully warmed file, for a later --since diff.")]
+    emit_manifest: Option<PathBuf>,
+
+    #[clap(long, value_name = "FILE", help = "Diff the tree against a previous --emit-manifest run: skip unchanged files, warm only the appended tail of files that grew, and fully warm anything new or rewritten. Turns a nightly re-warm after an incremental snapshot restore into minutes.")]
+    since: Option<PathBuf>,
+
+    #[clap(long, value_name = "FILE", conflicts_with = "directories", help = "Zero-discovery mode: stream paths from FILE ('-' for stdin) instead of walking directories. Newline- or NUL-delimited (auto-detected); an optional tab-separated size column skips the per-file stat entirely, so reads start within milliseconds of launch.")]
+    files_from: Option<PathBuf>,
+}
+
+/// Bytes to PathBuf for --files-from records; lossless on unix.
+fn path_from_bytes(bytes: &[u8]) -> PathBuf {
+    #[cfg(unix)]
+    {
+        use std::os::unix::ffi::OsStrExt;
+        PathBuf::from(std::ffi::OsStr::from_bytes(bytes))
+    }
+    #[cfg(not(unix))]
+    {
+        PathBuf::from(String::from_utf8_lossy(bytes).into_owned())
+    }
+}
+
+/// Parsed --cpu-set value. A newtype so clap treats the whole list as one
+/// argument instead of one CPU index per occurrence.
+#[derive(Clone, Debug)]
+struct CpuSet(Vec<usize>);
+
+/// Parse --cpu-set: comma-separated CPU indices and ranges, e.g. "0-3,8".
+fn parse_cpu_set(value: &str) -> Result<CpuSet, String> {
+    let mut cpus = Vec::new();
+    for part in value.split(',') {
+        let part = part.trim();
+        if let Some((lo, hi)) = part.split_once('-') {
+            let lo: usize = lo.trim().parse().map_err(|e| format!("bad CPU index: {}", e))?;
+            let hi: usize = hi.trim().parse().map_err(|e| format!("bad CPU index: {}", e))?;
+            if lo > hi {
+                return Err(format!("empty CPU range {}-{}", lo, hi));
+            }
+            cpus.extend(lo..=hi);
+        } else {
+            cpus.push(part.parse().map_err(|e| format!("bad CPU index: {}", e))?);
+        }
+    }
+    if cpus.is_empty() {
+        return Err("empty CPU set".to_string());
+    }
+    cpus.sort_unstable();
+    cpus.dedup();
+    Ok(CpuSet(cpus))
+}
+
+/// Apply --background / --cpu-set limits to the calling thread. Called on
+/// the main thread before the runtime starts (so helper threads spawned
+/// later inherit both settings) and from on_thread_start for every tokio
+/// worker and blocking-pool thread, which is what a process-level ionice
+/// wrapper misses.
+fn apply_thread_limits(background: bool, cpus: Option<&[usize]>) {
+    #[cfg(target_os = "linux")]
+    {
+        if background {
+            // IOPRIO_CLASS_IDLE (3) in bits 13+; who = IOPRIO_WHO_PROCESS
+            // (1) with pid 0 targets the calling thread.
+            const IOPRIO_CLASS_SHIFT: i64 = 13;
+            const IOPRIO_CLASS_IDLE: i64 = 3;
+            const IOPRIO_WHO_PROCESS: i64 = 1;
+            let rc = unsafe {
+                libc::syscall(
+                    libc::SYS_ioprio_set,
+                    IOPRIO_WHO_PROCESS,
+                    0,
+                    IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT,
+                )
+            };
+            if rc != 0 {
+                debug!("ioprio_set(idle) failed: {}", std::io::Error::last_os_error());
+            }
+        }
+        if let Some(cpus) = cpus {
+            unsafe {
+                let mut set: libc::cpu_set_t = std::mem::zeroed();
+                for &cpu in cpus {
+                    libc::CPU_SET(cpu, &mut set);
+                }
+                if libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) != 0 {
+                    debug!("sched_setaffinity failed: {}", std::io::Error::last_os_error());
+                }
+            }
+        }
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        let _ = (background, cpus);
+    }
+}
+
+/// Parse --shard I/N. The index is zero-based and must be below the count.
+fn parse_shard(value: &str) -> Result<(u64, u64), String> {
+    let (index, count) = value
+        .split_once('/')
+        .ok_or_else(|| "expected I/N, e.g. 0/4".to_string())?;
+    let index: u64 = index.trim().parse().map_err(|e| format!("bad shard index: {}", e))?;
+    let count: u64 = count.trim().parse().map_err(|e| format!("bad shard count: {}", e))?;
+    if count == 0 || index >= count {
+        return Err(format!("shard index {} out of range for {} shards", index, count));
+    }
+    Ok((index, count))
+}
+
+/// Does this file belong to the configured shard? Every node must compute
+/// the same assignment, so the inputs and the hash must both be stable
+/// across nodes: st_dev is out (it's a kernel-assigned number that can
+/// differ between instances attaching the same Multi-Attach volume), and so
+/// is DefaultHasher (its keys are explicitly unspecified across Rust
+/// releases). The inode alone identifies the file - one volume per warmed
+/// tree - hashed with inline FNV-1a. Nodes must also agree on the shard
+/// count, or files silently fall between shards; only the index differs.
+fn in_shard(meta: &warming::statx::FileMeta, path: &std::path::Path, shard: (u64, u64)) -> bool {
+    #[cfg(unix)]
+    let hash = {
+        let _ = path;
+        fnv1a(&meta.ino.to_le_bytes())
+    };
+    #[cfg(not(unix))]
+    let hash = {
+        let _ = meta;
+        fnv1a(path.to_string_lossy().as_bytes())
+    };
+    let (index, count) = shard;
+    hash % count == index
+}
+
+/// 64-bit FNV-1a. Hand-rolled because the shard assignment needs a hash
+/// with a pinned definition, not whatever DefaultHasher ships this release.
+fn fnv1a(bytes: &[u8]) -> u64 {
+    let mut hash = 0xcbf2_9ce4_8422_2325u64;
+    for &byte in bytes {
+        hash ^= byte as u64;
+        hash = hash.wrapping_mul(0x0000_0100_0000_01b3);
+    }
+    hash
 }
 
-#[tokio::main]
-async fn main() -> Result<()> {
+fn main() -> Result<()> {
     let args = Opts::parse();
 
+    // Limits go on the main thread first (helper threads spawned later -
+    // walker, checkpoint, cache-drop, per-core - inherit them) and on every
+    // runtime thread via the hook.
+    apply_thread_limits(args.background, args.cpu_set.as_ref().map(|c| c.0.as_slice()));
+    let mut builder = tokio::runtime::Builder::new_multi_thread();
+    builder.enable_all();
+    if args.background || args.cpu_set.is_some() {
+        let background = args.background;
+        let cpus = args.cpu_set.clone();
+        builder.on_thread_start(move || {
+            apply_thread_limits(background, cpus.as_ref().map(|c| c.0.as_slice()))
+        });
+    }
+    if let Some(cpus) = &args.cpu_set {
+        builder.worker_threads(cpus.0.len());
+    }
+    builder.build()?.block_on(run(args))
+}
+
+async fn run(args: Opts) -> Result<()> {
     // Start the profiler if the --profile flag is passed
     let guard = if args.profile {
         Some(pprof::ProfilerGuardBuilder::default()
@@ -112,37 +610,102 @@ async fn main() -> Result<()> {
     let total_start = Instant::now();
     debug!("Configuration: {:?}", args);
 
+    // Coordinator mode: union the per-shard checkpoint logs and exit. The
+    // merged log lets a later single-node (or re-sharded) run resume from
+    // everything any shard finished.
+    if let Some(inputs) = args.merge_checkpoints.as_ref() {
+        let output = args.checkpoint.as_ref().expect("clap enforces --checkpoint");
+        let merged = warming::checkpoint::merge(inputs, output)?;
+        println!(
+            "\u{1F9E9} Merged {} shard checkpoint logs into {} ({} unique files)",
+            inputs.len(),
+            output.display(),
+            merged
+        );
+        return Ok(());
+    }
+
+    // Pre-allocate the shared aligned buffer pool all O_DIRECT paths draw
+    // from. Background mode keeps it to a sliver of RSS; production gets
+    // the memory instead.
+    if args.background {
+        warming::buffers::init(8);
+    } else {
+        warming::buffers::init(args.queue_depth.max(32));
+    }
+    if args.background || args.cpu_set.is_some() {
+        let cpus = args
+            .cpu_set
+            .as_ref()
+            .map(|cpus| format!("CPUs {:?}", cpus.0))
+            .unwrap_or_else(|| "all CPUs".to_string());
+        println!(
+            "\u{1F319} Background mode: {} I/O class, {}, {} buffer slots",
+            if args.background { "idle" } else { "normal" },
+            cpus,
+            if args.background { 8 } else { args.queue_depth.max(32) }
+        );
+    }
+
     let multi_progress = MultiProgress::new();
-    let discovery_style = ProgressStyle::with_template(
-        "{spinner:.green} [{elapsed_precise}] Processing files: {pos}",
-    )
-    .unwrap();
 
-    let discovery_bar = multi_progress.add(ProgressBar::new_spinner());
-    discovery_bar.set_style(discovery_style);
-    discovery_bar.enable_steady_tick(std::time::Duration::from_millis(100));
+    let args = Arc::new(args);
 
-    let warming_style = ProgressStyle::with_template(
-        "{spinner:.green} [{elapsed_precise}] [{bar:40.cyan/blue}] Warmed files: {pos} ({rate}/s)",
-    )
-    .unwrap()
-    .progress_chars("#>-");
+    // Background worker that defers fadvise DONTNEED until readahead lands.
+    // Built before the engine so buffered engine jobs can use it too.
+    #[cfg(target_os = "linux")]
+    let cache_dropper = match warming::cache_drop::CacheDropper::new() {
+        Ok(dropper) => Some(std::sync::Arc::new(dropper)),
+        Err(e) => {
+            debug!("Failed to start cache-drop worker, dropping pages inline: {}", e);
+            None
+        }
+    };
 
-    let warming_bar = multi_progress.add(ProgressBar::new_spinner());
-    warming_bar.set_style(warming_style);
+    // Bring up the shared io_uring engine once; every file flows through it.
+    #[cfg(target_os = "linux")]
+    let uring_engine = if args.io_uring || args.auto_strategy {
+        match warming::engine::UringEngine::new(args.queue_depth, cache_dropper.clone()) {
+            Ok(engine) => Some(engine),
+            Err(e) => {
+                debug!("Failed to start io_uring engine, falling back to per-file strategy: {}", e);
+                None
+            }
+        }
+    } else {
+        None
+    };
 
-    let args = Arc::new(args);
-    
     // Convert CLI options to WarmingOptions
     let warming_options = WarmingOptions {
         use_io_uring: args.io_uring,
         use_libaio: args.libaio,
         use_direct_io: args.direct_io,
         sparse_large_files: args.sparse_large_files,
+        queue_depth: args.queue_depth,
+        auto_strategy: args.auto_strategy,
+        small_file_threshold: args.small_file_threshold,
+        huge_file_threshold: args.huge_file_threshold,
+        range_parallel_threshold: args.range_parallel_threshold,
+        skip_resident: args.skip_resident,
+        sparse_read_size: args.sparse_read_size,
+        sparse_stride: args.sparse_stride,
+        #[cfg(target_os = "linux")]
+        uring_engine,
+        #[cfg(target_os = "linux")]
+        cache_dropper,
     };
     
     // Display strategy selection at startup
-    if warming_options.use_io_uring || warming_options.use_libaio {
+    if warming_options.auto_strategy {
+        println!("🔧 Cache Warming Strategy: Automatic per-file selection by size class");
+        println!("   📦 <= {} bytes: batched ring reads", warming_options.small_file_threshold);
+        if warming_options.huge_file_threshold > 0 {
+            println!("   📡 >= {} bytes: sparse direct I/O", warming_options.huge_file_threshold);
+        }
+        println!("   💡 Everything else: OS hints with Tokio fallback");
+        println!();
+    } else if warming_options.use_io_uring || warming_options.use_libaio {
         println!("🔧 Cache Warming Strategy:");
         if warming_options.use_io_uring {
             #[cfg(target_os = "linux")]
@@ -169,76 +732,662 @@ async fn main() -> Result<()> {
         println!();
     }
     
-    // Use a channel-based approach for batch file processing
-    let (tx, rx) = mpsc::unbounded_channel::<Vec<PathBuf>>();
-    
-    // Spawn file discovery task
+    // Raw device mode: no file discovery, just stream the block range.
+    if let Some(device) = args.device.as_ref() {
+        let device_style = ProgressStyle::with_template(
+            "{spinner:.green} [{elapsed_precise}] Warmed {bytes} ({bytes_per_sec})",
+        )
+        .unwrap();
+        let device_bar = multi_progress.add(ProgressBar::new_spinner());
+        device_bar.set_style(device_style);
+        device_bar.enable_steady_tick(std::time::Duration::from_millis(100));
+
+        let warming_start = Instant::now();
+        let progress_bar = device_bar.clone();
+        let total_bytes =
+            warming::device::warm_device(device, args.range, &warming_options, move |bytes| {
+                progress_bar.inc(bytes)
+            })
+            .await?;
+        let warming_duration = warming_start.elapsed();
+
+        device_bar.finish_with_message(format!("Warmed {} bytes", total_bytes));
+        multi_progress.clear().unwrap();
+
+        let throughput_mbps = if warming_duration.as_secs_f64() > 0.0 {
+            (total_bytes as f64) / (1024.0 * 1024.0) / warming_duration.as_secs_f64()
+        } else {
+            0.0
+        };
+        info!(
+            "Device warming complete. Warmed {} bytes ({:.2} MB) from {} in {:.2?} at {:.2} MB/s.",
+            total_bytes,
+            total_bytes as f64 / (1024.0 * 1024.0),
+            device.display(),
+            warming_duration,
+            throughput_mbps
+        );
+        if !args.debug {
+            println!("Total execution time: {:.2?}", total_start.elapsed());
+        }
+        return Ok(());
+    }
+
+    let discovery_style = ProgressStyle::with_template(
+        "{spinner:.green} [{elapsed_precise}] Processing files: {pos}",
+    )
+    .unwrap();
+
+    let discovery_bar = multi_progress.add(ProgressBar::new_spinner());
+    discovery_bar.set_style(discovery_style);
+    discovery_bar.enable_steady_tick(std::time::Duration::from_millis(100));
+
+    let warming_style = ProgressStyle::with_template(
+        "{spinner:.green} [{elapsed_precise}] [{bar:40.cyan/blue}] Warmed files: {pos} ({rate}/s)",
+    )
+    .unwrap()
+    .progress_chars("#>-");
+
+    let warming_bar = multi_progress.add(ProgressBar::new_spinner());
+    warming_bar.set_style(warming_style);
+
+    // Load previously-completed files and start the checkpoint writer. The
+    // set makes the resume skip a single hash lookup per discovered file.
+    let (completed_files, checkpoint_writer) = match args.checkpoint.as_ref() {
+        Some(path) => {
+            let load_start = Instant::now();
+            let completed = warming::checkpoint::load(path)?;
+            if !completed.is_empty() {
+                println!(
+                    "⏩ Resuming from checkpoint: {} files already warmed (loaded in {:.2?})",
+                    completed.len(),
+                    load_start.elapsed()
+                );
+            }
+            let writer = warming::checkpoint::CheckpointWriter::new(path)?;
+            (Some(Arc::new(completed)), Some(Arc::new(writer)))
+        }
+        None => (None, None),
+    };
+
+    // Previous warm manifest for --since: discovery diffs each file against
+    // it instead of re-warming the whole tree after an incremental restore.
+    let since_manifest = match args.since.as_ref() {
+        Some(path) => {
+            let manifest = warming::manifest::Manifest::load(path)?;
+            println!(
+                "\u{1F5C2} Diffing against previous warm manifest: {} entries from {}",
+                manifest.len(),
+                path.display()
+            );
+            Some(Arc::new(manifest))
+        }
+        None => None,
+    };
+    // Collector for --emit-manifest; written once when the run finishes.
+    let manifest_writer = args
+        .emit_manifest
+        .as_ref()
+        .map(|_| Arc::new(warming::manifest::ManifestWriter::new()));
+
+    // Bounded discovery-to-warming channel: on a tree with tens of millions
+    // of files an unbounded queue of PathBufs is gigabytes of RSS, so cap
+    // queued discovery at roughly 64K files and let backpressure stall the
+    // walker threads instead. The receiver sits in an Option so exactly one
+    // execution mode below can claim it.
+    let channel_capacity = (65536 / args.batch_size.max(1)).clamp(4, 256);
+    let (tx, rx) = mpsc::channel::<Vec<FileEntry>>(channel_capacity);
+    let mut rx = Some(rx);
+
+    // Priority lane: files from --priority-file bypass the general queue and
+    // are warmed as soon as they surface. Always created; without a manifest
+    // it just closes when discovery starts.
+    let priority_manifest = match args.priority_file.as_ref() {
+        Some(path) => {
+            let manifest = PriorityManifest::load(path)?;
+            println!(
+                "⭐ Priority manifest: {} literal paths, globs {}",
+                manifest.literals.len(),
+                if manifest.globs.is_some() { "present" } else { "none" }
+            );
+            Some(Arc::new(manifest))
+        }
+        None => None,
+    };
+    if let Some((index, count)) = args.shard {
+        println!("\u{1F9E9} Sharded warming: this node takes shard {}/{} of the tree", index, count);
+    }
+    if let Some(source) = args.files_from.as_ref() {
+        println!(
+            "\u{1F4DC} Zero-discovery mode: streaming file list from {}",
+            if source.as_os_str() == "-" { "stdin".to_string() } else { source.display().to_string() }
+        );
+    }
+    let (ptx, prx) = mpsc::channel::<Vec<FileEntry>>(channel_capacity);
+    let mut prx = Some(prx);
+
+    // Spawn file discovery task. Discovery uses the parallel walker so
+    // directory reads across subtrees overlap - on a cold volume every
+    // dirent read hits S3 and serial traversal is the startup bottleneck.
     let discovery_args = Arc::clone(&args);
+    let discovery_completed = completed_files.clone();
+    let discovery_manifest = priority_manifest.clone();
+    let discovery_since = since_manifest.clone();
+    // Unchanged files skipped by the --since diff still belong in the next
+    // manifest: their blocks are hydrated, just not by this run. Without the
+    // carry-forward, a nightly --since/--emit-manifest chain would shrink
+    // the manifest to only tonight's changed files and re-warm everything
+    // else tomorrow.
+    let discovery_manifest_writer = manifest_writer.clone();
     let discovery_handle = tokio::spawn(async move {
-        let mut file_count = 0u64;
-        let mut current_batch = Vec::with_capacity(discovery_args.batch_size);
-        
-        for path in &discovery_args.directories {
-            debug!("Walking directory: {}", path.display());
-            let mut walker_builder = WalkBuilder::new(path);
+        tokio::task::spawn_blocking(move || {
+            // Warm the manifest's literal paths first, at full queue depth,
+            // before the walk produces anything.
+            let file_count = AtomicU64::new(0);
+            // Hardlink dedup: content-addressed stores map tens of millions
+            // of directory entries onto a few million inodes, and warming
+            // the same inode once per link multiplies the work for zero
+            // extra coverage. Only multi-link inodes enter the set, so
+            // ordinary trees pay nothing.
+            #[cfg(unix)]
+            let seen_inodes = std::sync::Mutex::new(std::collections::HashSet::<(u64, u64)>::new());
+            #[cfg(unix)]
+            let hardlink_skipped = AtomicU64::new(0);
+            // Keys are needed beyond checkpointing when a manifest is
+            // being emitted or diffed against.
+            let need_key = discovery_completed.is_some()
+                || discovery_args.emit_manifest.is_some()
+                || discovery_args.since.is_some();
+            let unchanged_skipped = AtomicU64::new(0);
+            let skipped_count = AtomicU64::new(0);
+            if let Some(manifest) = discovery_manifest.as_deref() {
+                let mut batch = Vec::new();
+                for path in &manifest.literals {
+                    match std::fs::metadata(path) {
+                        Ok(metadata) if metadata.is_file() => {
+                            let meta = warming::statx::FileMeta::from_std(&metadata);
+                            if let Some(shard) = discovery_args.shard {
+                                if !in_shard(&meta, path, shard) {
+                                    continue;
+                                }
+                            }
+                            #[cfg(unix)]
+                            {
+                                if meta.nlink > 1
+                                    && !seen_inodes.lock().unwrap().insert((meta.dev, meta.ino))
+                                {
+                                    hardlink_skipped.fetch_add(1, Ordering::Relaxed);
+                                    continue;
+                                }
+                            }
+                            let key = need_key.then(|| meta.key());
+                            if let (Some(set), Some(key)) = (discovery_completed.as_deref(), key) {
+                                if set.contains(&key) {
+                                    continue;
+                                }
+                            }
+                            let mut tail_start = None;
+                            if let (Some(since), Some(key)) = (discovery_since.as_deref(), key.as_ref()) {
+                                match since.diff(key) {
+                                    warming::manifest::Diff::Unchanged => {
+                                        // Carry forward: hydrated by the
+                                        // previous run, not this one.
+                                        if let Some(writer) = discovery_manifest_writer.as_deref() {
+                                            writer.record(*key);
+                                        }
+                                        unchanged_skipped.fetch_add(1, Ordering::Relaxed);
+                                        continue;
+                                    }
+                                    warming::manifest::Diff::Grown { from } => tail_start = Some(from),
+                                    warming::manifest::Diff::Changed => {}
+                                }
+                            }
+                            file_count.fetch_add(1, Ordering::Relaxed);
+                            batch.push(FileEntry { path: path.clone(), size: metadata.len(), mtime: meta.mtime, key, tail_start });
+                        }
+                        Ok(_) => debug!("Priority entry is not a regular file: {}", path.display()),
+                        Err(e) => debug!("Priority entry unavailable: {}: {}", path.display(), e),
+                    }
+                }
+                debug!("Dispatched {} priority files ahead of the walk", batch.len());
+                if !batch.is_empty() && ptx.blocking_send(batch).is_err() {
+                    return file_count.load(Ordering::Relaxed);
+                }
+            }
+
+            // Zero-discovery mode: stream the precomputed list straight
+            // into the batch channels and never touch the walker. The same
+            // filter chain as the walk applies whenever a record needs a
+            // stat; records that arrive with a size and need no metadata
+            // bypass the filesystem entirely.
+            if let Some(source) = discovery_args.files_from.as_ref() {
+                use std::io::BufRead;
+                let mut reader: Box<dyn std::io::BufRead> = if source.as_os_str() == "-" {
+                    Box::new(std::io::BufReader::new(std::io::stdin()))
+                } else {
+                    match std::fs::File::open(source) {
+                        Ok(file) => Box::new(std::io::BufReader::new(file)),
+                        Err(e) => {
+                            warn!("Cannot open file list {}: {}", source.display(), e);
+                            return file_count.load(Ordering::Relaxed);
+                        }
+                    }
+                };
+                // Delimiter sniffing: NUL-delimited lists (find -print0)
+                // show a NUL in the first buffered chunk.
+                let delim = match reader.fill_buf() {
+                    Ok(buf) if buf.contains(&0) => 0u8,
+                    _ => b'\n',
+                };
+                let mut batch = BatchSender::new(tx.clone(), discovery_args.batch_size);
+                let mut priority_batch = BatchSender::new(ptx.clone(), 1);
+                let mut record = Vec::new();
+                loop {
+                    record.clear();
+                    match reader.read_until(delim, &mut record) {
+                        Ok(0) => break,
+                        Ok(_) => {}
+                        Err(e) => {
+                            warn!("Error reading file list: {}", e);
+                            break;
+                        }
+                    }
+                    if record.last() == Some(&delim) {
+                        record.pop();
+                    }
+                    if delim == b'\n' && record.last() == Some(&b'\r') {
+                        record.pop();
+                    }
+                    if record.is_empty() {
+                        continue;
+                    }
+                    // Optional size column: "<path>\t<bytes>". A non-numeric
+                    // last column is treated as part of the path.
+                    let (path_bytes, listed_size) = match record.iter().rposition(|&b| b == b'\t') {
+                        Some(pos) => {
+                            match std::str::from_utf8(&record[pos + 1..])
+                                .ok()
+                                .and_then(|column| column.trim().parse::<u64>().ok())
+                            {
+                                Some(size) => (&record[..pos], Some(size)),
+                                None => (&record[..], None),
+                            }
+                        }
+                        None => (&record[..], None),
+                    };
+                    let path = path_from_bytes(path_bytes);
+
+                    let priority = discovery_manifest
+                        .as_deref()
+                        .map_or(false, |manifest| {
+                            !manifest.literal_set.contains(&path) && manifest.matches(&path)
+                        });
+                    if discovery_manifest
+                        .as_deref()
+                        .map_or(false, |manifest| manifest.literal_set.contains(&path))
+                    {
+                        // Already dispatched ahead of the stream.
+                        continue;
+                    }
+
+                    // Fast path: size supplied and nothing downstream needs
+                    // metadata - no stat at all, which is the point.
+                    let entry = if listed_size.is_some() && !need_key && discovery_args.shard.is_none() {
+                        // mtime is unknown without a stat; these sort last under
+                        // --warm-order mtime, which beats paying a stat per record.
+                        FileEntry { path, size: listed_size.unwrap(), mtime: 0, key: None, tail_start: None }
+                    } else {
+                        let metadata = match std::fs::metadata(&path) {
+                            Ok(metadata) if metadata.is_file() => metadata,
+                            Ok(_) => {
+                                debug!("File list entry is not a regular file: {}", path.display());
+                                continue;
+                            }
+                            Err(e) => {
+                                debug!("File list entry unavailable: {}: {}", path.display(), e);
+                                continue;
+                            }
+                        };
+                        let meta = warming::statx::FileMeta::from_std(&metadata);
+                        if let Some(shard) = discovery_args.shard {
+                            if !in_shard(&meta, &path, shard) {
+                                continue;
+                            }
+                        }
+                        #[cfg(unix)]
+                        {
+                            if meta.nlink > 1
+                                && !seen_inodes.lock().unwrap().insert((meta.dev, meta.ino))
+                            {
+                                hardlink_skipped.fetch_add(1, Ordering::Relaxed);
+                                continue;
+                            }
+                        }
+                        let key = need_key.then(|| meta.key());
+                        if let (Some(set), Some(key)) = (discovery_completed.as_deref(), key) {
+                            if set.contains(&key) {
+                                skipped_count.fetch_add(1, Ordering::Relaxed);
+                                continue;
+                            }
+                        }
+                        let mut tail_start = None;
+                        if let (Some(since), Some(key)) = (discovery_since.as_deref(), key.as_ref()) {
+                            match since.diff(key) {
+                                warming::manifest::Diff::Unchanged => {
+                                    // Skipped, but still part of the warm
+                                    // set the next manifest describes.
+                                    if let Some(writer) = discovery_manifest_writer.as_deref() {
+                                        writer.record(*key);
+                                    }
+                                    unchanged_skipped.fetch_add(1, Ordering::Relaxed);
+                                    continue;
+                                }
+                                warming::manifest::Diff::Grown { from } => tail_start = Some(from),
+                                warming::manifest::Diff::Changed => {}
+                            }
+                        }
+                        FileEntry { path, size: listed_size.unwrap_or_else(|| metadata.len()), mtime: meta.mtime, key, tail_start }
+                    };
+
+                    file_count.fetch_add(1, Ordering::Relaxed);
+                    let delivered = if priority { priority_batch.push(entry) } else { batch.push(entry) };
+                    if !delivered {
+                        debug!("Receiver dropped, stopping file list streaming");
+                        break;
+                    }
+                }
+                drop(batch);
+                drop(priority_batch);
+                let total = file_count.load(Ordering::Relaxed);
+                debug!("File list streaming complete. {} files queued.", total);
+                return total;
+            }
+
+            let mut directories = discovery_args.directories.iter();
+            let first = directories.next().expect("at least one directory");
+            debug!("Walking directories in parallel starting at: {}", first.display());
+            let mut walker_builder = WalkBuilder::new(first);
+            for path in directories {
+                walker_builder.add(path);
+            }
             let walker = walker_builder
                 .threads(discovery_args.threads.unwrap_or_else(num_cpus::get))
                 .follow_links(discovery_args.follow_symlinks)
                 .max_depth(discovery_args.max_depth)
                 .git_ignore(!discovery_args.respect_gitignore)
                 .hidden(discovery_args.ignore_hidden)
-                .build();
-
-            for result in walker {
-                match result {
-                    Ok(entry) => {
-                        if entry.file_type().map_or(false, |ft| ft.is_file()) {
-                            current_batch.push(entry.into_path());
-                            file_count += 1;
-                            
-                            // Send batch when it reaches the configured size
-                            if current_batch.len() >= discovery_args.batch_size {
-                                if tx.send(current_batch.clone()).is_err() {
-                                    debug!("Receiver dropped, stopping file discovery");
-                                    return file_count;
-                                }
-                                current_batch.clear();
+                .build_parallel();
+
+            walker.run(|| {
+                // Each walker thread gets its own sink: a statx batcher in
+                // front of the batch channels, so inode metadata for ~64
+                // files is fetched in one overlapped submit instead of one
+                // synchronous stat per dirent. The sink's Drop flushes the
+                // final partial batch; glob-matched priority files still
+                // flush immediately (capacity 1) so they never sit in a
+                // partial batch until the walk ends.
+                let mut sink = StatSink {
+                    pending: Vec::with_capacity(STAT_BATCH),
+                    stats: warming::statx::StatBatcher::new(STAT_BATCH),
+                    batch: BatchSender::new(tx.clone(), discovery_args.batch_size),
+                    priority_batch: BatchSender::new(ptx.clone(), 1),
+                    shard: discovery_args.shard,
+                    manifest: discovery_manifest.clone(),
+                    since: discovery_since.clone(),
+                    manifest_writer: discovery_manifest_writer.clone(),
+                    completed: discovery_completed.clone(),
+                    need_key,
+                    file_count: &file_count,
+                    skipped_count: &skipped_count,
+                    unchanged_skipped: &unchanged_skipped,
+                    #[cfg(unix)]
+                    seen_inodes: &seen_inodes,
+                    #[cfg(unix)]
+                    hardlink_skipped: &hardlink_skipped,
+                    stopped: false,
+                };
+                Box::new(move |result| {
+                    match result {
+                        Ok(entry) => {
+                            // file_type comes straight from the dirent - no
+                            // stat here; the sink batches those.
+                            if entry.file_type().map_or(false, |ft| ft.is_file())
+                                && !sink.accept(entry.into_path())
+                            {
+                                debug!("Receiver dropped, stopping file discovery");
+                                return ignore::WalkState::Quit;
                             }
                         }
+                        Err(err) => {
+                            debug!("Failed to process directory entry: {}", err);
+                        }
                     }
-                    Err(err) => {
-                        debug!("Failed to process directory entry: {}", err);
-                    }
+                    ignore::WalkState::Continue
+                })
+            });
+
+            let total = file_count.load(Ordering::Relaxed);
+            let skipped = skipped_count.load(Ordering::Relaxed);
+            if skipped > 0 {
+                debug!("Checkpoint resume skipped {} already-warmed files", skipped);
+            }
+            #[cfg(unix)]
+            {
+                let hardlinks = hardlink_skipped.load(Ordering::Relaxed);
+                if hardlinks > 0 {
+                    debug!("Hardlink dedup skipped {} extra links to already-queued inodes", hardlinks);
                 }
             }
-        }
-        
-        // Send any remaining files in the final batch
-        if !current_batch.is_empty() {
-            if tx.send(current_batch).is_err() {
-                debug!("Receiver dropped during final batch send");
+            let unchanged = unchanged_skipped.load(Ordering::Relaxed);
+            if unchanged > 0 {
+                debug!("Manifest diff skipped {} unchanged files", unchanged);
             }
-        }
-        
-        debug!("File discovery complete. {} files found.", file_count);
-        file_count
+            debug!("File discovery complete. {} files found.", total);
+            total
+        })
+        .await
+        .unwrap()
     });
 
-    let semaphore = Arc::new(Semaphore::new(args.queue_depth));
+    // With --adaptive-depth an AIMD controller tightens concurrency inside
+    // the fixed --queue-depth ceiling enforced by the stream below.
+    let adaptive = if args.adaptive_depth {
+        Some(warming::adaptive::AdaptiveController::new(args.queue_depth))
+    } else {
+        None
+    };
+    // Shared token bucket enforcing --max-bandwidth / --max-iops across all
+    // warming tasks; charges actual bytes read after each file.
+    let throttle = warming::throttle::Throttle::from_limits(
+        args.max_bandwidth * 1024 * 1024,
+        args.max_iops,
+    )
+    .map(Arc::new);
+    if throttle.is_some() {
+        println!(
+            "🚦 Throttling enabled: {} MB/s bandwidth, {} IOPS (0 = unlimited)",
+            args.max_bandwidth, args.max_iops
+        );
+    }
+    // Thread-per-core mode: shard files across per-core tokio-uring runtimes
+    // instead of the work-stealing pipeline below.
+    #[cfg(target_os = "linux")]
+    let run_default = args.engine != EngineMode::ThreadPerCore;
+    #[cfg(not(target_os = "linux"))]
+    let run_default = true;
+
+    // Structured metrics, collected only when an output file was requested.
+    // Per-core workers never record into the collector, so don't create one
+    // (and later write empty documents) in thread-per-core mode.
+    let metrics = if run_default && (args.metrics_json.is_some() || args.metrics_prometheus.is_some()) {
+        Some(Arc::new(warming::metrics::MetricsCollector::new()))
+    } else {
+        None
+    };
+
+    // With --verify, remember what was warmed so the verification pass can
+    // sample it afterwards. Path+size per file; only paid for when asked.
+    let verify_list = if args.verify {
+        Some(Arc::new(std::sync::Mutex::new(Vec::<(PathBuf, u64)>::new())))
+    } else {
+        None
+    };
+
     let total_bytes_warmed = Arc::new(AtomicU64::new(0));
     let processed_files = Arc::new(AtomicU64::new(0));
 
     debug!("Starting concurrent file warming");
     let warming_start = Instant::now();
 
+    #[cfg(target_os = "linux")]
+    if !run_default {
+        if manifest_writer.is_some() {
+            // Per-core workers report only aggregate stats, so there is no
+            // per-file success signal to build the manifest from.
+            warn!("--emit-manifest is not supported with --engine thread-per-core; no manifest will be written");
+        }
+        if args.metrics_json.is_some() || args.metrics_prometheus.is_some() {
+            // Same aggregate-only reporting: no per-strategy timings or
+            // timeline events to collect.
+            warn!("--metrics-json/--metrics-prometheus are not supported with --engine thread-per-core; no metrics will be written");
+        }
+        if args.warm_order.is_some() {
+            warn!("--warm-order is not supported with --engine thread-per-core; files warm in discovery order");
+        }
+        if args.physical_order {
+            warn!("--physical-order is not supported with --engine thread-per-core; files warm in discovery order");
+        }
+        if args.skip_resident {
+            warn!("--skip-resident is not supported with --engine thread-per-core; resident files are warmed anyway");
+        }
+        let workers = args.threads.unwrap_or_else(num_cpus::get);
+        let sharded = warming::per_core::ShardedWarmer::start(
+            workers,
+            &warming_options,
+            checkpoint_writer.clone(),
+            warming_bar.clone(),
+        )?;
+        let mut rx = rx.take().unwrap();
+        let mut prx = prx.take().unwrap();
+        loop {
+            // Biased select drains the priority lane before general batches.
+            let batch = tokio::select! {
+                biased;
+                Some(batch) = prx.recv() => batch,
+                Some(batch) = rx.recv() => batch,
+                else => break,
+            };
+            for FileEntry { path, size, key, .. } in batch {
+                discovery_bar.inc(1);
+                if args.max_file_size > 0 && size > args.max_file_size {
+                    debug!("Skipping large file: {} (size: {} > max: {})", path.display(), size, args.max_file_size);
+                    continue;
+                }
+                if let Some(list) = &verify_list {
+                    list.lock().unwrap().push((path.clone(), size));
+                }
+                sharded.dispatch(warming::per_core::Job { path, size, key }).await;
+            }
+        }
+        let stats = sharded.finish().await;
+        debug!(
+            "thread-per-core warming done: {} files, {} bytes, {} errors",
+            stats.files, stats.bytes, stats.errors
+        );
+        total_bytes_warmed.store(stats.bytes, Ordering::SeqCst);
+        processed_files.store(stats.files, Ordering::SeqCst);
+        warming_bar.set_position(stats.files);
+    }
+
+    if run_default {
+    let rx = rx.take().unwrap();
+    let prx = prx.take().unwrap();
     // Process file batches as they're discovered using a stream with controlled concurrency
-    let batch_stream = stream::unfold(rx, |mut rx| async move {
-        rx.recv().await.map(|batch| (batch, rx))
-    });
+    let batch_stream: std::pin::Pin<Box<dyn futures::Stream<Item = Vec<FileEntry>> + Send>> =
+        if args.physical_order || args.warm_order.is_some() {
+            // Scheduling stage: buffer discovery, sort the general lane by
+            // the chosen key, and put priority files (in arrival order)
+            // ahead of everything. Both lanes are drained concurrently so
+            // the bounded channels can't stall the walkers.
+            let warm_order = args.warm_order;
+            let (priority_files, all_files) = tokio::join!(
+                async {
+                    let mut prx = prx;
+                    let mut files = Vec::new();
+                    while let Some(batch) = prx.recv().await {
+                        files.extend(batch);
+                    }
+                    files
+                },
+                async {
+                    let mut rx = rx;
+                    let mut files = Vec::new();
+                    while let Some(batch) = rx.recv().await {
+                        files.extend(batch);
+                    }
+                    files
+                }
+            );
+            debug!(
+                "Sorting {} files ({} priority files go first)",
+                all_files.len(),
+                priority_files.len()
+            );
+            let sort_start = Instant::now();
+            let sorted = tokio::task::spawn_blocking(move || {
+                let mut keyed: Vec<(u64, FileEntry)> = all_files
+                    .into_iter()
+                    .map(|entry| {
+                        let sort_key = match warm_order {
+                            // Newest first: recency approximates the hot set.
+                            Some(WarmOrder::Mtime) => u64::MAX - entry.mtime.max(0) as u64,
+                            // Smallest first: warmed-file count ramps fastest.
+                            Some(WarmOrder::Size) => entry.size,
+                            None => warming::physical_sort_key(&entry.path),
+                        };
+                        (sort_key, entry)
+                    })
+                    .collect();
+                keyed.sort_unstable_by_key(|(key, _)| *key);
+                keyed.into_iter().map(|(_, entry)| entry).collect::<Vec<_>>()
+            })
+            .await
+            .unwrap();
+            debug!("Warm-order sort completed in {:?}", sort_start.elapsed());
+            Box::pin(
+                stream::iter(priority_files)
+                    .chunks(args.batch_size)
+                    .chain(stream::iter(sorted).chunks(args.batch_size)),
+            )
+        } else {
+            // Left-biased merge: whenever the priority lane has a batch
+            // ready it is dispatched before general discovery output.
+            let priority_stream = stream::unfold(prx, |mut prx| async move {
+                prx.recv().await.map(|batch| (batch, prx))
+            });
+            let general_stream = stream::unfold(rx, |mut rx| async move {
+                rx.recv().await.map(|batch| (batch, rx))
+            });
+            Box::pin(stream::select_with_strategy(
+                priority_stream,
+                general_stream,
+                |_: &mut ()| stream::PollNext::Left,
+            ))
+        };
 
+    // Flatten batches into one file stream so the single concurrency limit
+    // below is expressed in files in flight, not batches of unknown size.
+    // for_each_concurrent IS the limiter; the old per-batch semaphore
+    // stacked a second limit on top and effectively squared the depth.
     batch_stream
-        .for_each_concurrent(args.queue_depth, |file_batch| {
-            let semaphore = semaphore.clone();
+        .flat_map(stream::iter)
+        .for_each_concurrent(args.queue_depth, |FileEntry { path, size: file_size, key, tail_start, .. }| {
+            let adaptive = adaptive.clone();
+            let throttle = throttle.clone();
+            let metrics = metrics.clone();
+            let verify_list = verify_list.clone();
+            let manifest_writer = manifest_writer.clone();
+            let checkpoint_writer = checkpoint_writer.clone();
             let warming_bar = warming_bar.clone();
             let discovery_bar = discovery_bar.clone();
             let total_bytes_warmed = total_bytes_warmed.clone();
@@ -247,81 +1396,119 @@ async fn main() -> Result<()> {
             let warming_options = warming_options.clone();
 
             async move {
-                let batch_start = Instant::now();
-                let batch_size = file_batch.len();
-                
-                // Acquire semaphore once per batch
-                let acquire_start = Instant::now();
-                let _permit = semaphore.acquire().await.unwrap();
-                let wait_time = acquire_start.elapsed();
-                if wait_time > Duration::from_millis(10) {
-                    debug!("High semaphore wait time: {:?} for batch of {} files", wait_time, batch_size);
+                // Within the fixed ceiling, --adaptive-depth may hold
+                // this task back further.
+                let admit_start = Instant::now();
+                let mut _adaptive_permit = None;
+                if let Some(controller) = &adaptive {
+                    _adaptive_permit = Some(controller.acquire().await);
                 }
-                
-                // Process each file in the batch
-                for path in file_batch {
-                    let task_start = Instant::now();
-                    discovery_bar.inc(1);
-
-                    // Get file metadata
-                    let file_size = match tokio::fs::metadata(&path).await {
-                        Ok(metadata) => metadata.len(),
-                        Err(e) => {
-                            debug!("Failed to get metadata for {}: {}", path.display(), e);
-                            processed_files.fetch_add(1, Ordering::SeqCst);
-                            warming_bar.inc(1);
-                            continue;
-                        }
-                    };
+                let mut admit_wait = admit_start.elapsed();
 
-                    // Log file size category for distribution analysis
-                    let size_category = match file_size {
-                        0..=4096 => "tiny",
-                        4097..=65536 => "small", 
-                        65537..=1048576 => "medium",
-                        1048577..=104857600 => "large",
-                        _ => "huge"
-                    };
-                    debug!("Processing {} file: {} ({} bytes)", size_category, path.display(), file_size);
+                let task_start = Instant::now();
+                discovery_bar.inc(1);
 
-                    if args_clone.max_file_size > 0 && file_size > args_clone.max_file_size {
-                        debug!("Skipping large file: {} (size: {} > max: {})", path.display(), file_size, args_clone.max_file_size);
-                        processed_files.fetch_add(1, Ordering::SeqCst);
-                        warming_bar.inc(1);
-                        continue;
+                // Log file size category for distribution analysis
+                let size_category = match file_size {
+                    0..=4096 => "tiny",
+                    4097..=65536 => "small", 
+                    65537..=1048576 => "medium",
+                    1048577..=104857600 => "large",
+                    _ => "huge"
+                };
+                debug!("Processing {} file: {} ({} bytes)", size_category, path.display(), file_size);
+
+                if args_clone.max_file_size > 0 && file_size > args_clone.max_file_size {
+                    debug!("Skipping large file: {} (size: {} > max: {})", path.display(), file_size, args_clone.max_file_size);
+                    processed_files.fetch_add(1, Ordering::SeqCst);
+                    warming_bar.inc(1);
+                    return;
+                }
+
+                // Pause here if the token bucket is in debt from earlier reads.
+                if let Some(throttle) = &throttle {
+                    let wait_start = Instant::now();
+                    throttle.wait_ready().await;
+                    admit_wait += wait_start.elapsed();
+                }
+                if let Some(metrics) = &metrics {
+                    metrics.record_queue_wait(admit_wait);
+                }
+
+                // Use the modular warming interface
+                let _warming_start = Instant::now();
+                // Grown files from --since warm only the appended tail;
+                // everything else takes the normal strategy cascade.
+                let warm_outcome = match tail_start {
+                    Some(start) => {
+                        match warming::manifest::warm_tail(&path, start, file_size, &warming_options).await {
+                            Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {
+                                warm_file(&path, file_size, &warming_options).await
+                            }
+                            outcome => outcome,
+                        }
                     }
+                    None => warm_file(&path, file_size, &warming_options).await,
+                };
+                match warm_outcome {
+                    Ok(result) => {
+                        debug!("File {} warming completed: method={}, success={}, duration={:?}, size={}",
+                               path.display(), result.method, result.success, result.duration, file_size);
+
+                        if let Some(metrics) = &metrics {
+                            metrics.record_result(result.method, result.duration, result.bytes_read);
+                        }
+
+                        // Charge the actual cost: bytes as reported by the
+                        // strategy, ops approximated at one read per 64KB.
+                        if let Some(throttle) = &throttle {
+                            let ops = (result.bytes_read / 65536).max(1);
+                            throttle.consume(result.bytes_read, ops);
+                        }
 
-                    // Use the modular warming interface
-                    let _warming_start = Instant::now();
-                    match warm_file(&path, file_size, &warming_options).await {
-                        Ok(result) => {
-                            debug!("File {} warming completed: method={}, success={}, duration={:?}, size={}", 
-                                   path.display(), result.method, result.success, result.duration, file_size);
-                            
-                            // Log performance warnings for slow operations
-                            if result.duration > Duration::from_millis(100) {
-                                warn!("Slow warming operation: {} took {:?} for {} bytes", 
-                                      path.display(), result.duration, file_size);
+                        // Mark the file done so a resumed run skips it.
+                        if result.success {
+                            if let (Some(writer), Some(key)) = (&checkpoint_writer, key) {
+                                writer.record(key);
+                            }
+                            if let (Some(writer), Some(key)) = (&manifest_writer, key) {
+                                writer.record(key);
                             }
                         }
-                        Err(e) => {
-                            debug!("Failed to warm file {}: {}", path.display(), e);
+
+                        // Feed the controller a per-read latency estimate.
+                        if let Some(controller) = &adaptive {
+                            let reads = (file_size / 65536).max(1) as u32;
+                            controller.record(result.duration / reads);
+                        }
+
+                        // Log performance warnings for slow operations
+                        if result.duration > Duration::from_millis(100) {
+                            warn!("Slow warming operation: {} took {:?} for {} bytes", 
+                                  path.display(), result.duration, file_size);
                         }
                     }
+                    Err(e) => {
+                        debug!("Failed to warm file {}: {}", path.display(), e);
+                        if let Some(metrics) = &metrics {
+                            metrics.record_error();
+                        }
+                    }
+                }
 
-                    total_bytes_warmed.fetch_add(file_size, Ordering::SeqCst);
-                    processed_files.fetch_add(1, Ordering::SeqCst);
-                    warming_bar.inc(1);
-                    
-                    let total_task_time = task_start.elapsed();
-                    debug!("Total task time for {}: {:?}", path.display(), total_task_time);
+                if let Some(list) = &verify_list {
+                    list.lock().unwrap().push((path.clone(), file_size));
                 }
+                total_bytes_warmed.fetch_add(file_size, Ordering::SeqCst);
+                processed_files.fetch_add(1, Ordering::SeqCst);
+                warming_bar.inc(1);
                 
-                let batch_duration = batch_start.elapsed();
-                debug!("Completed batch of {} files in {:?}", batch_size, batch_duration);
+                let total_task_time = task_start.elapsed();
+                debug!("Total task time for {}: {:?}", path.display(), total_task_time);
             }
         })
         .await;
+    }
 
     // Wait for discovery to complete and get final count
     let total_files_discovered = discovery_handle.await.unwrap();
@@ -353,8 +1540,78 @@ async fn main() -> Result<()> {
     debug!("  Files per second: {:.2}", files_per_sec);
     debug!("  Average file size: {} bytes", avg_file_size);
     debug!("  Queue depth: {}", args.queue_depth);
+    if let Some(controller) = &adaptive {
+        debug!("  Final adaptive depth: {}", controller.current_depth());
+    }
     debug!("  Concurrency efficiency: {:.1}%", (total_files as f64 / warming_duration.as_secs_f64() / args.queue_depth as f64) * 100.0);
     
+    // Verification pass: prove hydration with cold-cache reads and give a
+    // second chance to anything that still looks S3-backed.
+    if let Some(list) = &verify_list {
+        let files = std::mem::take(&mut *list.lock().unwrap());
+        println!(
+            "\u{1F50D} Verifying {} files ({} samples each, threshold {}\u{00B5}s)",
+            files.len(),
+            args.verify_samples,
+            args.verify_threshold_us
+        );
+        let threshold = Duration::from_micros(args.verify_threshold_us);
+        let outcome =
+            warming::verify::verify_files(&files, args.verify_samples, threshold, args.queue_depth)
+                .await;
+        println!(
+            "   \u{23F1} Sample latency: p50 {}\u{00B5}s, p99 {}\u{00B5}s, max {}\u{00B5}s over {} samples",
+            outcome.latency.percentile(0.50),
+            outcome.latency.percentile(0.99),
+            outcome.latency.max_us(),
+            outcome.latency.count()
+        );
+        if outcome.cold.is_empty() {
+            println!("   \u{2705} No cold outliers: {} files verified", outcome.files_sampled);
+        } else {
+            println!(
+                "   \u{267B} Re-warming {} files with samples over the threshold",
+                outcome.cold.len()
+            );
+            stream::iter(outcome.cold)
+                .for_each_concurrent(args.queue_depth, |(path, size)| {
+                    let warming_options = warming_options.clone();
+                    async move {
+                        if let Err(e) = warm_file(&path, size, &warming_options).await {
+                            debug!("Re-warm failed for {}: {}", path.display(), e);
+                        }
+                    }
+                })
+                .await;
+        }
+    }
+
+    if let (Some(writer), Some(path)) = (&manifest_writer, &args.emit_manifest) {
+        match writer.write(path) {
+            Ok(count) => println!(
+                "\u{1F5C2} Warm manifest written to {} ({} files)",
+                path.display(),
+                count
+            ),
+            Err(e) => warn!("Failed to write warm manifest to {}: {}", path.display(), e),
+        }
+    }
+
+    if let Some(metrics) = &metrics {
+        if let Some(path) = &args.metrics_json {
+            match metrics.write_json(path) {
+                Ok(()) => println!("\u{1F4CA} Metrics written to {}", path.display()),
+                Err(e) => warn!("Failed to write metrics JSON to {}: {}", path.display(), e),
+            }
+        }
+        if let Some(path) = &args.metrics_prometheus {
+            match metrics.write_prometheus(path) {
+                Ok(()) => println!("\u{1F4CA} Prometheus metrics written to {}", path.display()),
+                Err(e) => warn!("Failed to write Prometheus metrics to {}: {}", path.display(), e),
+            }
+        }
+    }
+
     discovery_bar.finish_with_message(format!("Discovered {} files", total_files_discovered));
     warming_bar.finish_with_message(format!("Warmed {} files", processed_files.load(Ordering::SeqCst)));
     multi_progress.clear().unwrap();
@@ -0,0 +1,144 @@
+//! Adaptive queue-depth controller.
+//!
+//! EBS volumes behave very differently during hydration (reads hitting S3
+//! take 50-500ms) versus once partially warm (sub-ms), so any fixed
+//! --queue-depth is either too low early or collapses into queueing late.
+//! This AIMD controller samples observed per-read latency against a rolling
+//! minimum (the no-queueing baseline for the current regime) and adjusts the
+//! number of in-flight operations to sit at the throughput knee: additive
+//! increase while latency stays near the baseline, multiplicative decrease
+//! when latency inflates.
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+use log::debug;
+use tokio::sync::{OwnedSemaphorePermit, Semaphore};
+
+/// Latency within this factor of the baseline counts as "no queueing".
+const INCREASE_TOLERANCE: f64 = 2.0;
+/// Latency beyond this factor of the baseline triggers backoff.
+const DECREASE_TOLERANCE: f64 = 4.0;
+/// Samples between adjustment decisions.
+const ADJUST_WINDOW: u32 = 32;
+/// Samples between baseline resets, so the controller tracks regime changes
+/// (e.g. the volume finishing hydration) instead of a stale minimum.
+const BASELINE_RESET: u32 = 2048;
+/// EWMA smoothing factor for latency samples.
+const EWMA_ALPHA: f64 = 0.2;
+
+const MIN_DEPTH: usize = 4;
+const INCREASE_STEP: usize = 2;
+
+struct LatencyWindow {
+    ewma_ms: f64,
+    baseline_ms: f64,
+    samples: u32,
+    samples_since_reset: u32,
+}
+
+/// AIMD controller gating how many warming operations run concurrently.
+pub struct AdaptiveController {
+    semaphore: Arc<Semaphore>,
+    /// Permits the controller has decided to revoke but not yet collected.
+    debt: AtomicUsize,
+    /// Currently allowed in-flight operations.
+    allowed: AtomicUsize,
+    max_depth: usize,
+    window: Mutex<LatencyWindow>,
+}
+
+impl AdaptiveController {
+    /// Start at `max_depth / 2` and let the controller find the knee in
+    /// either direction, never exceeding the configured maximum.
+    pub fn new(max_depth: usize) -> Arc<Self> {
+        let initial = (max_depth / 2).max(MIN_DEPTH).min(max_depth);
+        Arc::new(AdaptiveController {
+            semaphore: Arc::new(Semaphore::new(initial)),
+            debt: AtomicUsize::new(0),
+            allowed: AtomicUsize::new(initial),
+            max_depth,
+            window: Mutex::new(LatencyWindow {
+                ewma_ms: 0.0,
+                baseline_ms: f64::MAX,
+                samples: 0,
+                samples_since_reset: 0,
+            }),
+        })
+    }
+
+    /// Acquire one in-flight slot, honouring any pending depth reduction.
+    pub async fn acquire(&self) -> OwnedSemaphorePermit {
+        loop {
+            let permit = self.semaphore.clone().acquire_owned().await.unwrap();
+            let debt = self.debt.load(Ordering::Acquire);
+            if debt > 0
+                && self
+                    .debt
+                    .compare_exchange(debt, debt - 1, Ordering::AcqRel, Ordering::Acquire)
+                    .is_ok()
+            {
+                // Retire this permit to shrink the effective depth.
+                permit.forget();
+                continue;
+            }
+            return permit;
+        }
+    }
+
+    /// Record an observed per-read latency sample and adjust depth when a
+    /// window completes.
+    pub fn record(&self, latency: Duration) {
+        let latency_ms = latency.as_secs_f64() * 1000.0;
+        let mut window = self.window.lock().unwrap();
+
+        window.ewma_ms = if window.samples == 0 {
+            latency_ms
+        } else {
+            window.ewma_ms * (1.0 - EWMA_ALPHA) + latency_ms * EWMA_ALPHA
+        };
+        window.baseline_ms = window.baseline_ms.min(window.ewma_ms);
+        window.samples += 1;
+        window.samples_since_reset += 1;
+
+        if window.samples_since_reset >= BASELINE_RESET {
+            window.baseline_ms = window.ewma_ms;
+            window.samples_since_reset = 0;
+        }
+
+        if window.samples % ADJUST_WINDOW != 0 {
+            return;
+        }
+
+        let allowed = self.allowed.load(Ordering::Acquire);
+        if window.ewma_ms <= window.baseline_ms * INCREASE_TOLERANCE {
+            // Latency near the baseline: room for more in flight.
+            let new_allowed = (allowed + INCREASE_STEP).min(self.max_depth);
+            if new_allowed > allowed {
+                self.semaphore.add_permits(new_allowed - allowed);
+                self.allowed.store(new_allowed, Ordering::Release);
+                debug!(
+                    "Adaptive depth: {} -> {} (ewma {:.1}ms, baseline {:.1}ms)",
+                    allowed, new_allowed, window.ewma_ms, window.baseline_ms
+                );
+            }
+        } else if window.ewma_ms > window.baseline_ms * DECREASE_TOLERANCE {
+            // Queueing detected: back off multiplicatively.
+            let new_allowed = (allowed / 2).max(MIN_DEPTH);
+            if new_allowed < allowed {
+                self.debt.fetch_add(allowed - new_allowed, Ordering::AcqRel);
+                self.allowed.store(new_allowed, Ordering::Release);
+                debug!(
+                    "Adaptive depth: {} -> {} (ewma {:.1}ms, baseline {:.1}ms)",
+                    allowed, new_allowed, window.ewma_ms, window.baseline_ms
+                );
+            }
+        }
+    }
+
+    /// Current allowed depth (for end-of-run reporting).
+    pub fn current_depth(&self) -> usize {
+        self.allowed.load(Ordering::Acquire)
+    }
+}
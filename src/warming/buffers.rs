@@ -0,0 +1,120 @@
+//! Process-wide aligned buffer pool for the O_DIRECT paths.
+//!
+//! Every warming strategy needs sector-aligned read buffers. Allocating and
+//! freeing them per file means millions of aligned-allocation round trips on
+//! big trees and long-run fragmentation, so the strategies instead check
+//! buffers out of one pre-allocated slab (sized queue depth x block size)
+//! and return them on drop. Requests larger than a slot, or arriving while
+//! the pool is exhausted, fall back to a private aligned allocation so
+//! callers never block on the pool.
+
+use std::sync::{Mutex, OnceLock};
+
+/// Slot size: matches the 64KB block the async strategies read with.
+pub const POOL_BLOCK_SIZE: usize = 65536;
+
+/// Alignment for O_DIRECT buffers.
+const ALIGNMENT: usize = 4096;
+
+static POOL: OnceLock<Pool> = OnceLock::new();
+
+struct Pool {
+    base: *mut u8,
+    // Kept alive for the life of the process; the slab is never freed.
+    _layout: std::alloc::Layout,
+    free: Mutex<Vec<u32>>,
+}
+
+// The pool hands out disjoint slots guarded by the free list, and the slab
+// itself is never freed, so sharing the raw base pointer is safe.
+unsafe impl Send for Pool {}
+unsafe impl Sync for Pool {}
+
+impl Pool {
+    fn new(slots: usize) -> Option<Pool> {
+        let layout = std::alloc::Layout::from_size_align(slots * POOL_BLOCK_SIZE, ALIGNMENT).ok()?;
+        let base = unsafe { std::alloc::alloc(layout) };
+        if base.is_null() {
+            return None;
+        }
+        Some(Pool {
+            base,
+            _layout: layout,
+            free: Mutex::new((0..slots as u32).rev().collect()),
+        })
+    }
+
+    fn slot_ptr(&self, slot: u32) -> *mut u8 {
+        unsafe { self.base.add(slot as usize * POOL_BLOCK_SIZE) }
+    }
+}
+
+/// Initialize the pool with `slots` slots. Call once at startup; later
+/// calls are no-ops. If the slab allocation fails every acquire just takes
+/// the private-allocation path. Callers pick the size (queue depth
+/// normally, a handful of slots in --background mode).
+pub fn init(slots: usize) {
+    if let Some(pool) = Pool::new(slots.max(4)) {
+        let _ = POOL.set(pool);
+    }
+}
+
+enum BufferKind {
+    Pooled(u32),
+    Owned(std::alloc::Layout),
+}
+
+/// An aligned read buffer checked out of the pool (or privately allocated
+/// when the pool can't serve the request). Returned on drop.
+pub struct PooledBuffer {
+    ptr: *mut u8,
+    kind: BufferKind,
+}
+
+unsafe impl Send for PooledBuffer {}
+
+impl PooledBuffer {
+    pub fn as_mut_ptr(&self) -> *mut u8 {
+        self.ptr
+    }
+}
+
+impl Drop for PooledBuffer {
+    fn drop(&mut self) {
+        match self.kind {
+            BufferKind::Pooled(slot) => {
+                // The pool outlives all buffers (it is never torn down).
+                if let Some(pool) = POOL.get() {
+                    pool.free.lock().unwrap().push(slot);
+                }
+            }
+            BufferKind::Owned(layout) => unsafe {
+                std::alloc::dealloc(self.ptr, layout);
+            },
+        }
+    }
+}
+
+/// Check out an aligned buffer of at least `size` bytes.
+pub fn acquire(size: usize) -> Result<PooledBuffer, std::io::Error> {
+    if size <= POOL_BLOCK_SIZE {
+        if let Some(pool) = POOL.get() {
+            if let Some(slot) = pool.free.lock().unwrap().pop() {
+                return Ok(PooledBuffer {
+                    ptr: pool.slot_ptr(slot),
+                    kind: BufferKind::Pooled(slot),
+                });
+            }
+        }
+    }
+
+    // Pool exhausted or oversized request: private aligned allocation.
+    let rounded = size.div_ceil(ALIGNMENT) * ALIGNMENT;
+    let layout = std::alloc::Layout::from_size_align(rounded, ALIGNMENT)
+        .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
+    let ptr = unsafe { std::alloc::alloc(layout) };
+    if ptr.is_null() {
+        return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
+    }
+    Ok(PooledBuffer { ptr, kind: BufferKind::Owned(layout) })
+}
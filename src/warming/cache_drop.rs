@@ -0,0 +1,133 @@
+use std::collections::VecDeque;
+use std::path::PathBuf;
+use std::sync::mpsc;
+use std::time::{Duration, Instant};
+
+use log::debug;
+
+use crate::warming::residency;
+
+/// Deferred cache-drop worker for the fadvise warming path.
+///
+/// POSIX_FADV_WILLNEED only *initiates* readahead; issuing DONTNEED on the
+/// same range in the same breath can cancel pages before the EBS fetch from
+/// S3 completes, leaving blocks cold after a "successful" warm. Instead of
+/// dropping immediately, warmed files are queued here and a background
+/// thread verifies the readahead actually landed (non-blocking residency
+/// probe) — or waits out a bounded grace period — before batching the
+/// DONTNEED calls. Correct warming at fadvise speed.
+
+/// Give readahead this long to land before dropping anyway.
+const MAX_WAIT: Duration = Duration::from_secs(2);
+
+/// Re-probe interval while files in the queue are still hydrating.
+const POLL_INTERVAL: Duration = Duration::from_millis(50);
+
+struct DropJob {
+    path: PathBuf,
+    file_size: u64,
+    enqueued: Instant,
+}
+
+#[derive(Debug)]
+pub struct CacheDropper {
+    tx: Option<mpsc::Sender<DropJob>>,
+    handle: Option<std::thread::JoinHandle<()>>,
+}
+
+impl CacheDropper {
+    pub fn new() -> Result<Self, std::io::Error> {
+        let (tx, rx) = mpsc::channel::<DropJob>();
+        let handle = std::thread::Builder::new()
+            .name("cache-drop".to_string())
+            .spawn(move || drop_loop(rx))?;
+        Ok(CacheDropper { tx: Some(tx), handle: Some(handle) })
+    }
+
+    /// Queue a file whose WILLNEED was just issued. Never blocks; if the
+    /// worker has died the pages simply stay cached (harmless).
+    pub fn enqueue(&self, path: PathBuf, file_size: u64) {
+        if let Some(tx) = &self.tx {
+            let _ = tx.send(DropJob { path, file_size, enqueued: Instant::now() });
+        }
+    }
+}
+
+impl Drop for CacheDropper {
+    fn drop(&mut self) {
+        // Close the channel; the worker drains its queue (still honoring
+        // residency checks and grace periods) and exits.
+        drop(self.tx.take());
+        if let Some(handle) = self.handle.take() {
+            let _ = handle.join();
+        }
+    }
+}
+
+fn drop_loop(rx: mpsc::Receiver<DropJob>) {
+    let mut pending: VecDeque<DropJob> = VecDeque::new();
+    let mut disconnected = false;
+
+    loop {
+        // Block for work only when idle; otherwise just drain what's queued.
+        if pending.is_empty() {
+            if disconnected {
+                return;
+            }
+            match rx.recv() {
+                Ok(job) => pending.push_back(job),
+                Err(_) => return,
+            }
+        }
+        loop {
+            match rx.try_recv() {
+                Ok(job) => pending.push_back(job),
+                Err(mpsc::TryRecvError::Empty) => break,
+                Err(mpsc::TryRecvError::Disconnected) => {
+                    disconnected = true;
+                    break;
+                }
+            }
+        }
+
+        // One pass over the queue: drop everything whose readahead has
+        // landed (or that has waited out the grace period), keep the rest.
+        let mut still_hydrating = VecDeque::new();
+        for job in pending.drain(..) {
+            // An Unsupported or failed probe falls back to the time bound.
+            let resident = residency::probe_path(&job.path, job.file_size).unwrap_or(false);
+            if resident || job.enqueued.elapsed() >= MAX_WAIT {
+                drop_pages(&job, resident);
+            } else {
+                still_hydrating.push_back(job);
+            }
+        }
+        pending = still_hydrating;
+
+        if !pending.is_empty() {
+            std::thread::sleep(POLL_INTERVAL);
+        }
+    }
+}
+
+/// Issue the actual DONTNEED for one hydrated file.
+fn drop_pages(job: &DropJob, verified: bool) {
+    use std::os::unix::ffi::OsStrExt;
+    let Ok(cpath) = std::ffi::CString::new(job.path.as_os_str().as_bytes()) else {
+        return;
+    };
+    let fd = unsafe { libc::open(cpath.as_ptr(), libc::O_RDONLY, 0) };
+    if fd < 0 {
+        debug!("Deferred drop: cannot reopen {}: {}", job.path.display(), std::io::Error::last_os_error());
+        return;
+    }
+    let rc = unsafe { libc::posix_fadvise(fd, 0, job.file_size as libc::off_t, libc::POSIX_FADV_DONTNEED) };
+    unsafe { libc::close(fd) };
+    debug!(
+        "Deferred drop for {} after {:?} ({}): {}",
+        job.path.display(),
+        job.enqueued.elapsed(),
+        if verified { "residency verified" } else { "grace period expired" },
+        if rc == 0 { "ok" } else { "failed" }
+    );
+}
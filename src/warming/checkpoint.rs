@@ -0,0 +1,194 @@
+use std::collections::HashSet;
+use std::io::{Read, Write};
+use std::path::{Path, PathBuf};
+use std::sync::mpsc;
+use std::time::Duration;
+
+use log::debug;
+
+/// Persistent checkpoint log so an interrupted warming run can resume
+/// without re-reading files it already finished.
+///
+/// The log is a flat sequence of fixed-size binary records, one per
+/// completed file, appended and fsynced in batches by a dedicated writer
+/// thread so the warming hot path never blocks on checkpoint I/O. On
+/// resume the whole log is loaded into a HashSet up front, making the
+/// per-file skip check during discovery a single hash lookup.
+
+/// One record: dev + inode + size + mtime, little-endian.
+pub(super) const RECORD_SIZE: usize = 32;
+
+/// Fsync after this many appended records (or on idle, whichever first).
+const FSYNC_BATCH: usize = 4096;
+
+/// Fsync pending records after this long without new completions.
+const FSYNC_IDLE: Duration = Duration::from_millis(500);
+
+/// Identity of a completed file. Size and mtime are included so a file
+/// that changed since the last run is warmed again rather than skipped.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct FileKey {
+    pub dev: u64,
+    pub ino: u64,
+    pub size: u64,
+    pub mtime: i64,
+}
+
+impl FileKey {
+    pub fn from_metadata(metadata: &std::fs::Metadata) -> FileKey {
+        #[cfg(unix)]
+        {
+            use std::os::unix::fs::MetadataExt;
+            FileKey {
+                dev: metadata.dev(),
+                ino: metadata.ino(),
+                size: metadata.len(),
+                mtime: metadata.mtime(),
+            }
+        }
+        #[cfg(not(unix))]
+        {
+            // No stable device/inode identity; size + mtime still catches
+            // most modifications.
+            let mtime = metadata
+                .modified()
+                .ok()
+                .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+                .map(|d| d.as_secs() as i64)
+                .unwrap_or(0);
+            FileKey { dev: 0, ino: 0, size: metadata.len(), mtime }
+        }
+    }
+
+    pub(super) fn to_bytes(self) -> [u8; RECORD_SIZE] {
+        let mut buf = [0u8; RECORD_SIZE];
+        buf[0..8].copy_from_slice(&self.dev.to_le_bytes());
+        buf[8..16].copy_from_slice(&self.ino.to_le_bytes());
+        buf[16..24].copy_from_slice(&self.size.to_le_bytes());
+        buf[24..32].copy_from_slice(&self.mtime.to_le_bytes());
+        buf
+    }
+
+    pub(super) fn from_bytes(buf: &[u8]) -> FileKey {
+        FileKey {
+            dev: u64::from_le_bytes(buf[0..8].try_into().unwrap()),
+            ino: u64::from_le_bytes(buf[8..16].try_into().unwrap()),
+            size: u64::from_le_bytes(buf[16..24].try_into().unwrap()),
+            mtime: i64::from_le_bytes(buf[24..32].try_into().unwrap()),
+        }
+    }
+}
+
+/// Load all completed-file keys from an existing checkpoint log. A missing
+/// file is an empty set (fresh run); a trailing partial record from a torn
+/// write is ignored.
+pub fn load(path: &Path) -> Result<HashSet<FileKey>, std::io::Error> {
+    let mut data = Vec::new();
+    match std::fs::File::open(path) {
+        Ok(mut file) => {
+            file.read_to_end(&mut data)?;
+        }
+        Err(e) if e.kind() == std::io::ErrorKind::NotFound => return Ok(HashSet::new()),
+        Err(e) => return Err(e),
+    }
+    let complete_records = data.len() / RECORD_SIZE;
+    if data.len() % RECORD_SIZE != 0 {
+        debug!(
+            "Checkpoint log has {} trailing bytes from an interrupted write, ignoring",
+            data.len() % RECORD_SIZE
+        );
+    }
+    let mut set = HashSet::with_capacity(complete_records);
+    for record in data.chunks_exact(RECORD_SIZE) {
+        set.insert(FileKey::from_bytes(record));
+    }
+    debug!("Loaded {} completed files from checkpoint {}", set.len(), path.display());
+    Ok(set)
+}
+
+/// Merge several per-shard checkpoint logs into one deduplicated log,
+/// for the coordinator host after a multi-node sharded warm. Returns the
+/// number of unique records written.
+pub fn merge(inputs: &[PathBuf], output: &Path) -> Result<usize, std::io::Error> {
+    let mut merged = HashSet::new();
+    for input in inputs {
+        let shard = load(input)?;
+        debug!("Merging {} records from {}", shard.len(), input.display());
+        merged.extend(shard);
+    }
+    let mut file = std::fs::File::create(output)?;
+    for key in &merged {
+        file.write_all(&key.to_bytes())?;
+    }
+    file.sync_all()?;
+    Ok(merged.len())
+}
+
+/// Appends completion records to the checkpoint log from a dedicated
+/// thread. `record` is a non-blocking channel send; the thread batches
+/// writes and fsyncs every FSYNC_BATCH records or FSYNC_IDLE of quiet.
+#[derive(Debug)]
+pub struct CheckpointWriter {
+    tx: Option<mpsc::Sender<FileKey>>,
+    handle: Option<std::thread::JoinHandle<()>>,
+}
+
+impl CheckpointWriter {
+    pub fn new(path: &PathBuf) -> Result<Self, std::io::Error> {
+        let mut file = std::fs::OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(path)?;
+        let (tx, rx) = mpsc::channel::<FileKey>();
+        let log_path = path.clone();
+        let handle = std::thread::Builder::new()
+            .name("checkpoint".to_string())
+            .spawn(move || {
+                let mut pending = 0usize;
+                loop {
+                    match rx.recv_timeout(FSYNC_IDLE) {
+                        Ok(key) => {
+                            if let Err(e) = file.write_all(&key.to_bytes()) {
+                                debug!("Checkpoint write failed for {}: {}", log_path.display(), e);
+                                continue;
+                            }
+                            pending += 1;
+                            if pending >= FSYNC_BATCH {
+                                let _ = file.sync_data();
+                                pending = 0;
+                            }
+                        }
+                        Err(mpsc::RecvTimeoutError::Timeout) => {
+                            if pending > 0 {
+                                let _ = file.sync_data();
+                                pending = 0;
+                            }
+                        }
+                        Err(mpsc::RecvTimeoutError::Disconnected) => {
+                            let _ = file.sync_data();
+                            break;
+                        }
+                    }
+                }
+            })?;
+        Ok(CheckpointWriter { tx: Some(tx), handle: Some(handle) })
+    }
+
+    /// Record one completed file. Never blocks; if the writer thread has
+    /// died the record is dropped (the file is simply re-warmed next run).
+    pub fn record(&self, key: FileKey) {
+        if let Some(tx) = &self.tx {
+            let _ = tx.send(key);
+        }
+    }
+}
+
+impl Drop for CheckpointWriter {
+    fn drop(&mut self) {
+        // Close the channel so the writer drains, fsyncs, and exits.
+        drop(self.tx.take());
+        if let Some(handle) = self.handle.take() {
+            let _ = handle.join();
+        }
+    }
+}
@@ -0,0 +1,494 @@
+//! Shared io_uring warming engine.
+//!
+//! Instead of building (and tearing down) a ring per file, a small pool of
+//! worker threads each owns one long-lived ring. Files flow to workers over
+//! channels and many files are multiplexed on each ring at once, so small
+//! files don't pay ring setup cost and the configured queue depth is kept
+//! full across file boundaries. Where the kernel supports it, small files
+//! are warmed with a linked OPENAT -> READ -> CLOSE chain against the fixed
+//! file table, costing zero blocking syscalls on the hot path.
+
+use std::collections::{HashMap, VecDeque};
+use std::ffi::CString;
+use std::os::unix::ffi::OsStrExt;
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+
+use io_uring::{opcode, squeue, types, IoUring};
+use log::debug;
+use tokio::sync::{mpsc, oneshot};
+
+use crate::warming::io_uring::{AlignedSlots, FULL_BLOCK_SIZE};
+
+/// A single file warming request handed to a worker.
+struct WarmJob {
+    path: PathBuf,
+    file_size: u64,
+    block_size: usize,
+    stride: u64,
+    direct_io: bool,
+    done: oneshot::Sender<Result<u64, std::io::Error>>,
+}
+
+/// Long-lived warming engine shared by all files.
+pub struct UringEngine {
+    workers: Vec<mpsc::UnboundedSender<WarmJob>>,
+    next_worker: AtomicUsize,
+}
+
+impl std::fmt::Debug for UringEngine {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("UringEngine")
+            .field("workers", &self.workers.len())
+            .finish()
+    }
+}
+
+impl UringEngine {
+    /// Create the engine: one ring per worker thread, rings live for the
+    /// whole run. Buffered jobs hand their pages to `cache_dropper` when
+    /// one is supplied. Fails (so callers can fall back) if the kernel has
+    /// no io_uring support at all.
+    pub fn new(
+        queue_depth: usize,
+        cache_dropper: Option<Arc<crate::warming::cache_drop::CacheDropper>>,
+    ) -> Result<Arc<Self>, std::io::Error> {
+        let worker_count = num_cpus::get().min(4).max(1);
+        // Split the requested depth across workers so total in-flight I/O
+        // still matches --queue-depth.
+        let per_worker_depth = (queue_depth / worker_count).max(8).next_power_of_two();
+
+        let mut workers = Vec::with_capacity(worker_count);
+        for worker_id in 0..worker_count {
+            let ring = IoUring::new(per_worker_depth as u32).map_err(|e| {
+                if e.raw_os_error() == Some(libc::ENOSYS) {
+                    std::io::Error::new(std::io::ErrorKind::Unsupported, "io_uring not supported by kernel")
+                } else {
+                    e
+                }
+            })?;
+            let buffers = AlignedSlots::new(per_worker_depth, FULL_BLOCK_SIZE)?;
+            let (tx, rx) = mpsc::unbounded_channel::<WarmJob>();
+            let dropper = cache_dropper.clone();
+            std::thread::Builder::new()
+                .name(format!("uring-warm-{}", worker_id))
+                .spawn(move || worker_loop(ring, buffers, rx, per_worker_depth, dropper))?;
+            workers.push(tx);
+        }
+
+        debug!(
+            "io_uring engine started: {} workers, ring depth {} each",
+            worker_count, per_worker_depth
+        );
+        Ok(Arc::new(UringEngine {
+            workers,
+            next_worker: AtomicUsize::new(0),
+        }))
+    }
+
+    /// Warm one file through the shared engine with the caller's read
+    /// geometry. Returns bytes read.
+    pub async fn warm(
+        &self,
+        path: PathBuf,
+        file_size: u64,
+        block_size: usize,
+        stride: u64,
+        direct_io: bool,
+    ) -> Result<u64, std::io::Error> {
+        let (done_tx, done_rx) = oneshot::channel();
+        let worker = self.next_worker.fetch_add(1, Ordering::Relaxed) % self.workers.len();
+        self.workers[worker]
+            .send(WarmJob { path, file_size, block_size, stride, direct_io, done: done_tx })
+            .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "io_uring engine worker unavailable"))?;
+        done_rx
+            .await
+            .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "io_uring engine dropped job"))?
+    }
+}
+
+/// How a worker refers to an open file.
+enum FileFd {
+    /// Normally opened descriptor (large files).
+    Raw(libc::c_int),
+    /// Fixed-table index opened via a linked OPENAT chain (small files).
+    Fixed,
+}
+
+/// Per-file bookkeeping while its reads are in flight on the ring.
+struct FileState {
+    fd: FileFd,
+    /// Next read offset within the current allocated range.
+    next_offset: u64,
+    /// End of the current allocated range.
+    cur_end: u64,
+    /// Remaining allocated ranges still to be read (holes are skipped).
+    ranges: VecDeque<(u64, u64)>,
+    block_size: usize,
+    stride: u64,
+    outstanding: u32,
+    bytes_read: u64,
+    first_error: Option<i32>,
+    /// Buffered job: the reads populated the page cache, which must be
+    /// dropped again once the file drains (we only want the EBS warming).
+    buffered: bool,
+    path: PathBuf,
+    file_size: u64,
+    done: Option<oneshot::Sender<Result<u64, std::io::Error>>>,
+    // Keeps the pathname alive while an OPENAT SQE references it.
+    _cpath: Option<CString>,
+}
+
+// user_data layout: | tag (8 bits) | file id (40 bits) | slot (16 bits) |
+const TAG_OPEN: u64 = 1;
+const TAG_READ: u64 = 2;
+const TAG_CLOSE: u64 = 3;
+
+fn encode_user_data(tag: u64, file_id: u64, slot: u16) -> u64 {
+    (tag << 56) | (file_id << 16) | slot as u64
+}
+
+fn decode_user_data(data: u64) -> (u64, u64, u16) {
+    (data >> 56, (data >> 16) & 0xFF_FFFF_FFFF, (data & 0xFFFF) as u16)
+}
+
+fn worker_loop(
+    mut ring: IoUring,
+    buffers: AlignedSlots,
+    mut rx: mpsc::UnboundedReceiver<WarmJob>,
+    depth: usize,
+    dropper: Option<Arc<crate::warming::cache_drop::CacheDropper>>,
+) {
+    // Fixed file table enables the zero-syscall OPENAT/READ/CLOSE chain;
+    // older kernels reject sparse registration, in which case small files
+    // just take the regular open path.
+    let use_fixed = ring.submitter().register_files_sparse(depth as u32).is_ok();
+    debug!("io_uring worker: fixed file table {}", if use_fixed { "enabled" } else { "unavailable" });
+
+    // Register the slot arena with the kernel so reads can use the zero-copy
+    // fixed-buffer path (IORING_REGISTER_BUFFERS).
+    let iovecs: Vec<libc::iovec> = (0..depth)
+        .map(|slot| libc::iovec {
+            iov_base: buffers.slot_ptr(slot).cast(),
+            iov_len: FULL_BLOCK_SIZE,
+        })
+        .collect();
+    let use_registered_buffers = unsafe { ring.submitter().register_buffers(&iovecs).is_ok() };
+    debug!("io_uring worker: registered buffers {}", if use_registered_buffers { "enabled" } else { "unavailable" });
+
+    let mut free_slots: Vec<u16> = (0..depth as u16).rev().collect();
+    let mut active: HashMap<u64, FileState> = HashMap::new();
+    let mut next_file_id = 0u64;
+    let mut in_flight = 0usize;
+
+    loop {
+        // Block for work only when fully idle; otherwise admit what's ready.
+        if active.is_empty() {
+            match rx.blocking_recv() {
+                Some(job) => admit(&mut ring, &buffers, &mut active, &mut free_slots,
+                                   &mut next_file_id, &mut in_flight, use_fixed,
+                                   use_registered_buffers, job),
+                None => return,
+            }
+        }
+        while active.len() < depth && !free_slots.is_empty() {
+            match rx.try_recv() {
+                Ok(job) => admit(&mut ring, &buffers, &mut active, &mut free_slots,
+                                 &mut next_file_id, &mut in_flight, use_fixed,
+                                 use_registered_buffers, job),
+                Err(_) => break,
+            }
+        }
+
+        // Keep the ring full: issue reads for every active raw-fd file.
+        'issue: for (&file_id, state) in active.iter_mut() {
+            if let FileFd::Raw(fd) = state.fd {
+                loop {
+                    if state.next_offset >= state.cur_end {
+                        // Advance to the next allocated range, skipping holes.
+                        match state.ranges.pop_front() {
+                            Some((range_start, range_end)) => {
+                                state.next_offset = range_start;
+                                state.cur_end = range_end;
+                                continue;
+                            }
+                            None => break,
+                        }
+                    }
+                    let Some(slot) = free_slots.pop() else { break 'issue };
+                    let entry = if use_registered_buffers {
+                        opcode::ReadFixed::new(types::Fd(fd), buffers.slot_ptr(slot as usize), state.block_size as u32, slot)
+                            .offset(state.next_offset)
+                            .build()
+                            .user_data(encode_user_data(TAG_READ, file_id, slot))
+                    } else {
+                        opcode::Read::new(types::Fd(fd), buffers.slot_ptr(slot as usize), state.block_size as u32)
+                            .offset(state.next_offset)
+                            .build()
+                            .user_data(encode_user_data(TAG_READ, file_id, slot))
+                    };
+                    if !push_entry(&mut ring, &entry) {
+                        free_slots.push(slot);
+                        break 'issue;
+                    }
+                    state.outstanding += 1;
+                    in_flight += 1;
+                    state.next_offset += state.stride;
+                }
+            }
+        }
+
+        // Finalize files that completed without needing the CQ (e.g. empty
+        // files, or immediate open failures already reported).
+        finalize_ready(&mut active, dropper.as_deref());
+
+        if in_flight == 0 {
+            continue;
+        }
+
+        if let Err(e) = ring.submit_and_wait(1) {
+            match e.raw_os_error() {
+                Some(libc::EINTR) | Some(libc::EAGAIN) | Some(libc::EBUSY) => continue,
+                _ => {
+                    debug!("io_uring worker submit failed: {}", e);
+                    fail_all(&mut active, e);
+                    return;
+                }
+            }
+        }
+
+        let completions: Vec<(u64, i32)> = ring.completion().map(|cqe| (cqe.user_data(), cqe.result())).collect();
+        for (user_data, result) in completions {
+            let (tag, file_id, slot) = decode_user_data(user_data);
+            in_flight -= 1;
+            let Some(state) = active.get_mut(&file_id) else {
+                free_slots.push(slot);
+                continue;
+            };
+            state.outstanding -= 1;
+            match tag {
+                TAG_OPEN => {
+                    if result < 0 {
+                        state.first_error = Some(-result);
+                    }
+                }
+                TAG_READ => {
+                    if result > 0 {
+                        state.bytes_read += result as u64;
+                    } else if result < 0 && result != -libc::ECANCELED {
+                        state.first_error.get_or_insert(-result);
+                        debug!("io_uring engine read error: {}", std::io::Error::from_raw_os_error(-result));
+                    }
+                    // Raw-file reads own their slot only for one read; chain
+                    // reads keep it until the linked close completes.
+                    if matches!(state.fd, FileFd::Raw(_)) {
+                        free_slots.push(slot);
+                    }
+                }
+                TAG_CLOSE => {
+                    free_slots.push(slot);
+                }
+                _ => {}
+            }
+        }
+
+        finalize_ready(&mut active, dropper.as_deref());
+    }
+}
+
+/// Push an SQE, flushing the submission queue if it is full.
+fn push_entry(ring: &mut IoUring, entry: &squeue::Entry) -> bool {
+    unsafe {
+        if ring.submission().push(entry).is_ok() {
+            return true;
+        }
+    }
+    if ring.submit().is_err() {
+        return false;
+    }
+    unsafe { ring.submission().push(entry).is_ok() }
+}
+
+/// Free SQ entries available without a flush.
+fn sq_space(ring: &mut IoUring) -> usize {
+    let sq = ring.submission();
+    sq.capacity() - sq.len()
+}
+
+#[allow(clippy::too_many_arguments)]
+fn admit(
+    ring: &mut IoUring,
+    buffers: &AlignedSlots,
+    active: &mut HashMap<u64, FileState>,
+    free_slots: &mut Vec<u16>,
+    next_file_id: &mut u64,
+    in_flight: &mut usize,
+    use_fixed: bool,
+    use_registered_buffers: bool,
+    job: WarmJob,
+) {
+    let file_id = *next_file_id & 0xFF_FFFF_FFFF;
+    *next_file_id += 1;
+
+    // Ring buffer slots are FULL_BLOCK_SIZE; clamp the read size to fit
+    // (coverage is unaffected, reads just get denser within the stride).
+    let block_size = job.block_size.min(FULL_BLOCK_SIZE);
+    let stride = job.stride.max(block_size as u64);
+
+    let open_flags = libc::O_RDONLY | if job.direct_io { libc::O_DIRECT } else { 0 };
+
+    let Ok(cpath) = CString::new(job.path.as_os_str().as_bytes()) else {
+        let _ = job.done.send(Err(std::io::Error::new(std::io::ErrorKind::InvalidInput, "path contains NUL byte")));
+        return;
+    };
+
+    // Small files on a fixed-table kernel: one linked OPENAT/READ/CLOSE
+    // chain, no blocking syscalls at all.
+    if use_fixed && job.file_size <= block_size as u64 {
+        if let Some(slot) = free_slots.pop() {
+            // A link chain must be contiguous in one submission.
+            if sq_space(ring) < 3 && ring.submit().is_err() {
+                free_slots.push(slot);
+            } else {
+                let open_entry = opcode::OpenAt::new(types::Fd(libc::AT_FDCWD), cpath.as_ptr())
+                    .flags(open_flags)
+                    .file_index(types::DestinationSlot::try_from_slot_target(slot as u32).ok())
+                    .build()
+                    .flags(squeue::Flags::IO_LINK)
+                    .user_data(encode_user_data(TAG_OPEN, file_id, slot));
+                let read_entry = if use_registered_buffers {
+                    opcode::ReadFixed::new(types::Fixed(slot as u32), buffers.slot_ptr(slot as usize), block_size as u32, slot)
+                        .offset(0)
+                        .build()
+                        .flags(squeue::Flags::IO_LINK)
+                        .user_data(encode_user_data(TAG_READ, file_id, slot))
+                } else {
+                    opcode::Read::new(types::Fixed(slot as u32), buffers.slot_ptr(slot as usize), block_size as u32)
+                        .offset(0)
+                        .build()
+                        .flags(squeue::Flags::IO_LINK)
+                        .user_data(encode_user_data(TAG_READ, file_id, slot))
+                };
+                let close_entry = opcode::Close::new(types::Fixed(slot as u32))
+                    .build()
+                    .user_data(encode_user_data(TAG_CLOSE, file_id, slot));
+
+                let mut pushed = 0;
+                for entry in [&open_entry, &read_entry, &close_entry] {
+                    if push_entry(ring, entry) {
+                        pushed += 1;
+                    } else {
+                        break;
+                    }
+                }
+                if pushed == 3 {
+                    *in_flight += 3;
+                    active.insert(file_id, FileState {
+                        fd: FileFd::Fixed,
+                        // The chain covers the whole file; nothing further to issue.
+                        next_offset: 0,
+                        cur_end: 0,
+                        ranges: VecDeque::new(),
+                        block_size,
+                        stride,
+                        outstanding: 3,
+                        bytes_read: 0,
+                        first_error: None,
+                        buffered: !job.direct_io,
+                        path: job.path,
+                        file_size: job.file_size,
+                        done: Some(job.done),
+                        _cpath: Some(cpath),
+                    });
+                    return;
+                }
+                // Partial chain push shouldn't happen (we reserved space),
+                // but fall through to the regular open path if it does.
+                debug!("io_uring engine: linked chain push incomplete ({}/3), using open(2)", pushed);
+            }
+        }
+    }
+
+    // Regular path: blocking open once, then multiplexed ring reads.
+    let fd = unsafe { libc::open(cpath.as_ptr(), open_flags, 0) };
+    if fd < 0 {
+        let _ = job.done.send(Err(std::io::Error::last_os_error()));
+        return;
+    }
+    // Only read allocated extents; holes have no S3-backed blocks.
+    let ranges: VecDeque<(u64, u64)> =
+        crate::warming::extents::data_ranges(fd, job.file_size).into_iter().collect();
+    active.insert(file_id, FileState {
+        fd: FileFd::Raw(fd),
+        next_offset: 0,
+        cur_end: 0,
+        ranges,
+        block_size,
+        stride,
+        outstanding: 0,
+        bytes_read: 0,
+        first_error: None,
+        buffered: !job.direct_io,
+        path: job.path,
+        file_size: job.file_size,
+        done: Some(job.done),
+        _cpath: None,
+    });
+}
+
+/// Complete every file whose I/O has fully drained.
+fn finalize_ready(
+    active: &mut HashMap<u64, FileState>,
+    dropper: Option<&crate::warming::cache_drop::CacheDropper>,
+) {
+    active.retain(|_, state| {
+        if state.outstanding > 0 || state.next_offset < state.cur_end || !state.ranges.is_empty() {
+            return true;
+        }
+        if let FileFd::Raw(fd) = state.fd {
+            // Buffered reads populated the page cache; drop it before the
+            // close - we only wanted EBS warming, not OS caching. The reads
+            // have all completed, so no hydration grace period is needed.
+            if state.buffered {
+                unsafe { libc::posix_fadvise(fd, 0, 0, libc::POSIX_FADV_DONTNEED) };
+            }
+            unsafe { libc::close(fd) };
+        } else if state.buffered {
+            // Linked chains closed their fd on the ring; the dropper reopens
+            // the path to issue the DONTNEED (or we do so here when no
+            // dropper is running).
+            if let Some(dropper) = dropper {
+                dropper.enqueue(std::mem::take(&mut state.path), state.file_size);
+            } else if let Some(cpath) = &state._cpath {
+                let fd = unsafe { libc::open(cpath.as_ptr(), libc::O_RDONLY, 0) };
+                if fd >= 0 {
+                    unsafe {
+                        libc::posix_fadvise(fd, 0, 0, libc::POSIX_FADV_DONTNEED);
+                        libc::close(fd);
+                    }
+                }
+            }
+        }
+        if let Some(done) = state.done.take() {
+            let result = match state.first_error {
+                Some(errno) if state.bytes_read == 0 => Err(std::io::Error::from_raw_os_error(errno)),
+                _ => Ok(state.bytes_read),
+            };
+            let _ = done.send(result);
+        }
+        false
+    });
+}
+
+/// Abort all in-flight files with the given error (worker shutdown path).
+fn fail_all(active: &mut HashMap<u64, FileState>, error: std::io::Error) {
+    for (_, mut state) in active.drain() {
+        if let FileFd::Raw(fd) = state.fd {
+            unsafe { libc::close(fd) };
+        }
+        if let Some(done) = state.done.take() {
+            let _ = done.send(Err(std::io::Error::new(error.kind(), error.to_string())));
+        }
+    }
+}
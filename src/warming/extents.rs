@@ -0,0 +1,126 @@
+//! File extent mapping for hole-aware warming.
+//!
+//! Sparse VM images and database preallocations carry large holes that have
+//! no S3-backed blocks, so reading them only wastes EBS I/O on zeros. This
+//! module maps a file's allocated ranges with SEEK_DATA/SEEK_HOLE so the
+//! warming strategies can issue reads only against real data.
+
+use log::debug;
+
+#[cfg(target_os = "linux")]
+use libc;
+
+/// O_DIRECT offsets must stay sector aligned, so range starts are rounded
+/// down to this boundary.
+const RANGE_ALIGNMENT: u64 = 4096;
+
+// FIEMAP ioctl ABI (include/uapi/linux/fiemap.h); not exposed by the libc
+// crate.
+#[cfg(target_os = "linux")]
+const FS_IOC_FIEMAP: libc::c_ulong = 0xC020660B;
+
+#[cfg(target_os = "linux")]
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct FiemapExtent {
+    fe_logical: u64,
+    fe_physical: u64,
+    fe_length: u64,
+    fe_reserved64: [u64; 2],
+    fe_flags: u32,
+    fe_reserved: [u32; 3],
+}
+
+#[cfg(target_os = "linux")]
+#[repr(C)]
+struct FiemapRequest {
+    fm_start: u64,
+    fm_length: u64,
+    fm_flags: u32,
+    fm_mapped_extents: u32,
+    fm_extent_count: u32,
+    fm_reserved: u32,
+    fm_extents: [FiemapExtent; 1],
+}
+
+/// Physical (on-disk) byte address of the file's first extent, via FIEMAP.
+/// Returns None when the filesystem doesn't support FIEMAP or the file has
+/// no mapped extents, so callers can sort unknowns to the back.
+#[cfg(target_os = "linux")]
+pub fn physical_offset(path: &std::path::Path) -> Option<u64> {
+    use std::os::unix::ffi::OsStrExt;
+    let cpath = std::ffi::CString::new(path.as_os_str().as_bytes()).ok()?;
+    let fd = unsafe { libc::open(cpath.as_ptr(), libc::O_RDONLY, 0) };
+    if fd < 0 {
+        return None;
+    }
+
+    let mut request = FiemapRequest {
+        fm_start: 0,
+        fm_length: u64::MAX,
+        fm_flags: 0,
+        fm_mapped_extents: 0,
+        fm_extent_count: 1,
+        fm_reserved: 0,
+        fm_extents: [FiemapExtent {
+            fe_logical: 0,
+            fe_physical: 0,
+            fe_length: 0,
+            fe_reserved64: [0; 2],
+            fe_flags: 0,
+            fe_reserved: [0; 3],
+        }],
+    };
+
+    let rc = unsafe { libc::ioctl(fd, FS_IOC_FIEMAP, &mut request) };
+    unsafe { libc::close(fd) };
+
+    if rc < 0 || request.fm_mapped_extents == 0 {
+        return None;
+    }
+    Some(request.fm_extents[0].fe_physical)
+}
+
+/// Map the allocated byte ranges of `fd`. Returns `[(start, end)]` pairs in
+/// ascending order, with starts aligned down for O_DIRECT. Filesystems
+/// without SEEK_DATA support (or any unexpected error) yield the whole file
+/// as a single range, so callers never read less than they would have.
+#[cfg(target_os = "linux")]
+pub fn data_ranges(fd: libc::c_int, file_size: u64) -> Vec<(u64, u64)> {
+    if file_size == 0 {
+        return Vec::new();
+    }
+
+    let mut ranges: Vec<(u64, u64)> = Vec::new();
+    let mut offset: libc::off_t = 0;
+
+    loop {
+        let data_start = unsafe { libc::lseek(fd, offset, libc::SEEK_DATA) };
+        if data_start < 0 {
+            let e = std::io::Error::last_os_error();
+            if e.raw_os_error() == Some(libc::ENXIO) {
+                // No data past this offset: the rest of the file is a hole.
+                break;
+            }
+            // EINVAL and friends: no SEEK_DATA support, warm everything.
+            debug!("SEEK_DATA unsupported ({}), treating file as fully allocated", e);
+            return vec![(0, file_size)];
+        }
+
+        let hole_start = unsafe { libc::lseek(fd, data_start, libc::SEEK_HOLE) };
+        if hole_start < 0 {
+            debug!("SEEK_HOLE failed ({}), treating file as fully allocated", std::io::Error::last_os_error());
+            return vec![(0, file_size)];
+        }
+
+        let start = (data_start as u64) & !(RANGE_ALIGNMENT - 1);
+        ranges.push((start, (hole_start as u64).min(file_size)));
+
+        offset = hole_start;
+        if offset as u64 >= file_size {
+            break;
+        }
+    }
+
+    ranges
+}
@@ -10,11 +10,12 @@ use nix::fcntl::{posix_fadvise, PosixFadviseAdvice};
 #[cfg(target_os = "macos")]
 use nix::sys::mman::{madvise, MmapAdvise};
 
-use crate::warming::WarmingResult;
+use crate::warming::{WarmingOptions, WarmingResult};
 
 pub async fn warm_with_os_hints(
     path: &PathBuf,
     file_size: u64,
+    options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
     let start = Instant::now();
     
@@ -23,7 +24,7 @@ pub async fn warm_with_os_hints(
     let (method, success) = if cfg!(target_os = "linux") {
         #[cfg(target_os = "linux")]
         {
-            let result = warm_with_fadvise(&file, file_size);
+            let result = warm_with_fadvise(&file, file_size, path, options);
             ("linux_fadvise", result)
         }
         #[cfg(not(target_os = "linux"))]
@@ -44,11 +45,13 @@ pub async fn warm_with_os_hints(
         method,
         success,
         duration: start.elapsed(),
+        // Hint-based warming touches the whole file.
+        bytes_read: if success { file_size } else { 0 },
     })
 }
 
 #[cfg(target_os = "linux")]
-fn warm_with_fadvise(file: &File, file_size: u64) -> bool {
+fn warm_with_fadvise(file: &File, file_size: u64, path: &PathBuf, options: &WarmingOptions) -> bool {
     let start = Instant::now();
     let fd = file.as_raw_fd();
     
@@ -56,9 +59,21 @@ fn warm_with_fadvise(file: &File, file_size: u64) -> bool {
     let warm_result = posix_fadvise(fd, 0, file_size as i64, PosixFadviseAdvice::POSIX_FADV_WILLNEED).is_ok();
     
     if warm_result {
-        // Step 2: Immediately drop from cache (we only wanted EBS warming, not OS caching)
-        let drop_result = posix_fadvise(fd, 0, file_size as i64, PosixFadviseAdvice::POSIX_FADV_DONTNEED).is_ok();
-        debug!("fadvise WILLNEED+DONTNEED took {:?}, warm: {}, drop: {}", start.elapsed(), warm_result, drop_result);
+        // Step 2: drop from cache (we only wanted EBS warming, not OS
+        // caching) - but WILLNEED only *initiates* the readahead, and an
+        // immediate DONTNEED can cancel pages before the EBS fetch lands.
+        // Hand the drop to the deferred worker, which verifies residency
+        // first; only fall back to the racy immediate drop without one.
+        match options.cache_dropper.as_ref() {
+            Some(dropper) => {
+                dropper.enqueue(path.clone(), file_size);
+                debug!("fadvise WILLNEED took {:?}, drop deferred until hydrated", start.elapsed());
+            }
+            None => {
+                let drop_result = posix_fadvise(fd, 0, file_size as i64, PosixFadviseAdvice::POSIX_FADV_DONTNEED).is_ok();
+                debug!("fadvise WILLNEED+DONTNEED took {:?}, warm: {}, drop: {}", start.elapsed(), warm_result, drop_result);
+            }
+        }
         
         // Success if we managed to warm (drop is less critical)
         warm_result
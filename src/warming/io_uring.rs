@@ -2,11 +2,25 @@ use std::path::PathBuf;
 use std::time::Instant;
 use log::debug;
 
+#[cfg(target_os = "linux")]
+use io_uring::{opcode, types, IoUring};
 #[cfg(target_os = "linux")]
 use libc;
 
 use crate::warming::{WarmingResult, WarmingOptions};
 
+/// Block size for full-file reads. 64KB matches the EBS sector fetch size well.
+#[cfg(target_os = "linux")]
+pub(super) const FULL_BLOCK_SIZE: usize = 65536;
+
+/// Minimum block size (and O_DIRECT alignment) for sparse reads. The actual
+/// sparse read size and stride come from --sparse-read-size/--sparse-stride,
+/// defaulting to one 4KB read per 512KiB EBS snapshot block: touching any
+/// byte of a snapshot block hydrates the whole block from S3, so a denser
+/// stride only adds operations, not coverage.
+#[cfg(target_os = "linux")]
+pub(super) const SPARSE_BLOCK_SIZE: usize = 4096;
+
 /// Warm file using io_uring with optional direct I/O
 #[cfg(target_os = "linux")]
 pub async fn warm_file(
@@ -14,10 +28,33 @@ pub async fn warm_file(
     file_size: u64,
     options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
+    // Prefer the shared engine: one long-lived ring per worker, no per-file
+    // ring setup cost.
+    if let Some(engine) = options.uring_engine.as_ref() {
+        let start = Instant::now();
+        let sparse = options.sparse_large_files > 0 && file_size > options.sparse_large_files;
+        let (block_size, stride) = options.sparse_geometry(sparse);
+        let bytes_read = engine
+            .warm(path.clone(), file_size, block_size, stride, options.use_direct_io)
+            .await?;
+        debug!(
+            "io_uring engine completed ({}): {} bytes read in {:?}",
+            if sparse { "sparse" } else { "full" },
+            bytes_read,
+            start.elapsed()
+        );
+        return Ok(WarmingResult {
+            method: if sparse { "io_uring_engine_sparse" } else { "io_uring_engine_full" },
+            success: true,
+            duration: start.elapsed(),
+            bytes_read,
+        });
+    }
+
     debug!("Using io_uring + direct I/O for maximum EBS warming performance: {}", path.display());
-    
+
     if options.use_direct_io {
-        warm_with_io_uring_direct(path, file_size, options.sparse_large_files).await
+        warm_with_io_uring_direct(path, file_size, options).await
     } else {
         // For now, if not using direct I/O, fall back to standard approach
         debug!("io_uring without direct I/O not yet implemented, falling back");
@@ -32,138 +69,199 @@ pub async fn warm_file(
 async fn warm_with_io_uring_direct(
     path: &PathBuf,
     file_size: u64,
-    sparse_large_files: u64,
+    options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
-    // For now, use libc direct I/O instead of complex io_uring setup
-    // This provides the same EBS warming benefits with simpler implementation
     let start = Instant::now();
-    
-    // Open file with O_DIRECT
-    let fd = unsafe {
-        libc::open(
-            std::ffi::CString::new(path.to_string_lossy().as_ref()).unwrap().as_ptr(),
-            libc::O_RDONLY | libc::O_DIRECT,
-            0,
-        )
-    };
-    
-    if fd < 0 {
-        return Err(std::io::Error::last_os_error());
-    }
-    
-    let result = if sparse_large_files > 0 && file_size > sparse_large_files {
-        warm_sparse_io_uring_direct(fd, file_size).await
-    } else {
-        warm_full_io_uring_direct(fd).await
-    };
-    
-    unsafe { libc::close(fd) };
-    result
-}
+    let path = path.clone();
+    let sparse = options.sparse_large_files > 0 && file_size > options.sparse_large_files;
+    let (block_size, stride) = options.sparse_geometry(sparse);
+    let queue_depth = options.queue_depth;
 
-#[cfg(target_os = "linux")]
-async fn warm_sparse_io_uring_direct(
-    fd: libc::c_int,
-    file_size: u64,
-) -> Result<WarmingResult, std::io::Error> {
-    let start = Instant::now();
-    
-    let block_size = 4096u64; // Standard block size
-    let stride = 65536u64; // Read every 64KB
-    let mut bytes_read = 0u64;
-    
-    // Allocate aligned buffer for direct I/O
-    let layout = std::alloc::Layout::from_size_align(block_size as usize, block_size as usize)
-        .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
-    let buffer = unsafe { std::alloc::alloc(layout) };
-    if buffer.is_null() {
-        return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
-    }
-    
-    let mut offset = 0;
-    while offset < file_size {
-        // Use pread for direct I/O (io_uring would do similar but with async queuing)
-        let result = unsafe {
-            libc::pread(fd, buffer.cast(), block_size as usize, offset as libc::off_t)
+    // The ring submit/harvest loop is blocking, so keep it off the async executor.
+    let bytes_read = tokio::task::spawn_blocking(move || {
+        // Open file with O_DIRECT
+        let fd = unsafe {
+            libc::open(
+                std::ffi::CString::new(path.to_string_lossy().as_ref()).unwrap().as_ptr(),
+                libc::O_RDONLY | libc::O_DIRECT,
+                0,
+            )
         };
-        
-        if result > 0 {
-            bytes_read += result as u64;
-        } else if result == 0 {
-            break; // EOF
-        } else {
-            debug!("io_uring read error at offset {}: {}", offset, std::io::Error::last_os_error());
-            // Continue with next block on error
+
+        if fd < 0 {
+            return Err(std::io::Error::last_os_error());
         }
-        
-        offset += stride;
-        
-        // Yield to allow other tasks to run (simulating async behavior)
-        tokio::task::yield_now().await;
-    }
-    
-    unsafe { 
-        std::alloc::dealloc(buffer, layout);
-    }
-    
-    debug!("Sparse io_uring + direct I/O completed: {} bytes read in {:?}", bytes_read, start.elapsed());
+
+        // Only read allocated extents; holes have no S3-backed blocks.
+        let result = (|| {
+            let mut total = 0u64;
+            for (range_start, range_end) in crate::warming::extents::data_ranges(fd, file_size) {
+                total += ring_read(fd, range_start, range_end, block_size, stride, queue_depth)?;
+            }
+            Ok(total)
+        })();
+
+        unsafe { libc::close(fd) };
+        result
+    })
+    .await
+    .map_err(|e| std::io::Error::new(std::io::ErrorKind::Other, e))??;
+
+    debug!(
+        "io_uring + direct I/O completed ({}): {} bytes read in {:?}",
+        if sparse { "sparse" } else { "full" },
+        bytes_read,
+        start.elapsed()
+    );
     Ok(WarmingResult {
-        method: "io_uring_direct_sparse",
+        method: if sparse { "io_uring_direct_sparse" } else { "io_uring_direct_full" },
         success: true,
         duration: start.elapsed(),
+        bytes_read,
     })
 }
 
+/// Aligned buffer arena for O_DIRECT reads: one slot per in-flight SQE.
 #[cfg(target_os = "linux")]
-async fn warm_full_io_uring_direct(
-    fd: libc::c_int,
-) -> Result<WarmingResult, std::io::Error> {
-    let start = Instant::now();
-    
-    let block_size = 65536; // 64KB blocks for efficient reading
-    let mut total_bytes_read = 0u64;
-    let mut offset = 0;
-    
-    // Allocate aligned buffer for direct I/O
-    let layout = std::alloc::Layout::from_size_align(block_size, block_size)
-        .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
-    let buffer = unsafe { std::alloc::alloc(layout) };
-    if buffer.is_null() {
-        return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
+pub(super) struct AlignedSlots {
+    base: *mut u8,
+    layout: std::alloc::Layout,
+    slot_size: usize,
+}
+
+// The arena exclusively owns its heap allocation, so it is safe to move
+// between threads (e.g. into an engine worker).
+#[cfg(target_os = "linux")]
+unsafe impl Send for AlignedSlots {}
+
+#[cfg(target_os = "linux")]
+impl AlignedSlots {
+    pub(super) fn new(slots: usize, slot_size: usize) -> Result<Self, std::io::Error> {
+        let layout = std::alloc::Layout::from_size_align(slots * slot_size, SPARSE_BLOCK_SIZE)
+            .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
+        let base = unsafe { std::alloc::alloc(layout) };
+        if base.is_null() {
+            return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
+        }
+        Ok(AlignedSlots { base, layout, slot_size })
     }
-    
-    loop {
-        // Use pread for direct I/O (io_uring would do similar but with async queuing)
-        let result = unsafe {
-            libc::pread(fd, buffer.cast(), block_size, offset as libc::off_t)
-        };
-        
-        if result > 0 {
-            total_bytes_read += result as u64;
-            offset += result;
-        } else if result == 0 {
-            break; // EOF
+
+    pub(super) fn slot_ptr(&self, slot: usize) -> *mut u8 {
+        unsafe { self.base.add(slot * self.slot_size) }
+    }
+}
+
+#[cfg(target_os = "linux")]
+impl Drop for AlignedSlots {
+    fn drop(&mut self) {
+        unsafe { std::alloc::dealloc(self.base, self.layout) };
+    }
+}
+
+/// Core submission/completion loop: keeps up to `queue_depth` reads in flight
+/// against `fd`, issuing one read of `block_size` bytes every `stride` bytes
+/// over the byte range `[start, end)`.
+#[cfg(target_os = "linux")]
+pub(super) fn ring_read(
+    fd: libc::c_int,
+    start: u64,
+    end: u64,
+    block_size: usize,
+    stride: u64,
+    queue_depth: usize,
+) -> Result<u64, std::io::Error> {
+    // Don't build a deeper ring than the range has blocks to read.
+    let blocks_needed = (end.saturating_sub(start) / stride).max(1);
+    let depth = queue_depth
+        .max(1)
+        .min(blocks_needed as usize)
+        .next_power_of_two();
+
+    let mut ring = IoUring::new(depth as u32).map_err(|e| {
+        // ENOSYS means the kernel has no io_uring; surface that as Unsupported
+        // so the strategy selector can fall through to the next tier.
+        if e.raw_os_error() == Some(libc::ENOSYS) {
+            std::io::Error::new(std::io::ErrorKind::Unsupported, "io_uring not supported by kernel")
         } else {
-            unsafe { 
-                std::alloc::dealloc(buffer, layout);
+            e
+        }
+    })?;
+
+    let buffers: Vec<crate::warming::buffers::PooledBuffer> = (0..depth)
+        .map(|_| crate::warming::buffers::acquire(block_size))
+        .collect::<Result<_, _>>()?;
+    let mut free_slots: Vec<usize> = (0..depth).collect();
+    let mut next_offset = start;
+    let mut in_flight = 0usize;
+    let mut bytes_read = 0u64;
+
+    loop {
+        // Fill the submission queue with as many reads as we have free slots.
+        while next_offset < end {
+            let Some(slot) = free_slots.pop() else { break };
+            let read_entry = opcode::Read::new(types::Fd(fd), buffers[slot].as_mut_ptr(), block_size as u32)
+                .offset(next_offset)
+                .build()
+                .user_data(slot as u64);
+            let pushed = unsafe { ring.submission().push(&read_entry).is_ok() };
+            if !pushed {
+                free_slots.push(slot);
+                break;
+            }
+            in_flight += 1;
+            next_offset += stride;
+        }
+
+        if in_flight == 0 {
+            break;
+        }
+
+        // Submit and block until at least one completion is ready. Signals
+        // (e.g. SIGPROF from --profile) interrupt the wait; retry those like
+        // the engine worker loop does. On a fatal error we must NOT return
+        // while reads are still in flight: the kernel would keep DMA-ing into
+        // `buffers` after this frame drops them. Reap the outstanding
+        // completions first, then surface the error.
+        if let Err(e) = ring.submit_and_wait(1) {
+            match e.raw_os_error() {
+                Some(libc::EINTR) | Some(libc::EAGAIN) | Some(libc::EBUSY) => continue,
+                _ => {
+                    quiesce(&mut ring, in_flight);
+                    return Err(e);
+                }
+            }
+        }
+
+        // Harvest everything on the completion queue.
+        for cqe in ring.completion() {
+            in_flight -= 1;
+            free_slots.push(cqe.user_data() as usize);
+            let result = cqe.result();
+            if result > 0 {
+                bytes_read += result as u64;
+            } else if result < 0 && result != -(libc::EINTR) {
+                debug!("io_uring read error: {}", std::io::Error::from_raw_os_error(-result));
+                // Continue with remaining blocks on error
             }
-            return Err(std::io::Error::last_os_error());
         }
-        
-        // Yield to allow other tasks to run (simulating async behavior)
-        tokio::task::yield_now().await;
     }
-    
-    unsafe { 
-        std::alloc::dealloc(buffer, layout);
+
+    Ok(bytes_read)
+}
+
+/// Wait out every in-flight read before `ring_read`'s buffers are dropped.
+/// Completions are posted whether or not we look at them, so this only has
+/// to drain the CQ; results are discarded since the caller is already
+/// returning an error.
+#[cfg(target_os = "linux")]
+fn quiesce(ring: &mut IoUring, mut in_flight: usize) {
+    while in_flight > 0 {
+        in_flight = in_flight.saturating_sub(ring.completion().count());
+        if in_flight > 0 && ring.submit_and_wait(1).is_err() {
+            // Even the wait is failing; poll instead of spinning.
+            std::thread::sleep(std::time::Duration::from_millis(1));
+        }
     }
-    
-    debug!("Full io_uring + direct I/O completed: {} bytes read in {:?}", total_bytes_read, start.elapsed());
-    Ok(WarmingResult {
-        method: "io_uring_direct_full",
-        success: true,
-        duration: start.elapsed(),
-    })
 }
 
 // Stub implementation for non-Linux systems
@@ -177,4 +275,4 @@ pub async fn warm_file(
         std::io::ErrorKind::Unsupported,
         "io_uring only supported on Linux"
     ))
-} 
\ No newline at end of file
+}
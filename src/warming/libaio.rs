@@ -7,7 +7,25 @@ use libc;
 
 use crate::warming::{WarmingResult, WarmingOptions};
 
-/// Warm file using Linux AIO (libaio) with optional direct I/O
+// Kernel AIO ABI pieces the libc crate doesn't expose. These match
+// include/uapi/linux/aio_abi.h and are stable kernel ABI.
+#[cfg(target_os = "linux")]
+type AioContext = libc::c_ulong;
+
+#[cfg(target_os = "linux")]
+const IOCB_CMD_PREAD: u16 = 0;
+
+#[cfg(target_os = "linux")]
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct IoEvent {
+    data: u64,
+    obj: u64,
+    res: i64,
+    res2: i64,
+}
+
+/// Warm file using Linux AIO (io_submit/io_getevents) with optional direct I/O
 #[cfg(target_os = "linux")]
 pub async fn warm_file(
     path: &PathBuf,
@@ -15,15 +33,16 @@ pub async fn warm_file(
     options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
     debug!("Using libaio + direct I/O for high-performance EBS warming: {}", path.display());
-    
+
     if options.use_direct_io {
-        warm_with_libaio_direct(path, file_size, options.sparse_large_files).await
+        warm_with_libaio_direct(path, file_size, options).await
     } else {
-        // For now, if not using direct I/O, fall back to standard approach
-        debug!("libaio without direct I/O not yet implemented, falling back");
+        // Kernel AIO is only truly asynchronous with O_DIRECT; without it
+        // io_submit degrades to synchronous reads, so fall back instead.
+        debug!("libaio without direct I/O would be synchronous, falling back");
         Err(std::io::Error::new(
             std::io::ErrorKind::Unsupported,
-            "libaio without direct I/O not yet implemented"
+            "libaio requires direct I/O for asynchronous reads"
         ))
     }
 }
@@ -32,130 +51,208 @@ pub async fn warm_file(
 async fn warm_with_libaio_direct(
     path: &PathBuf,
     file_size: u64,
-    sparse_large_files: u64,
+    options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
     let start = Instant::now();
-    
-    // Open file with O_DIRECT
-    let fd = unsafe {
-        libc::open(
-            std::ffi::CString::new(path.to_string_lossy().as_ref()).unwrap().as_ptr(),
-            libc::O_RDONLY | libc::O_DIRECT,
-            0,
-        )
-    };
-    
-    if fd < 0 {
-        return Err(std::io::Error::last_os_error());
-    }
-    
-    let result = if sparse_large_files > 0 && file_size > sparse_large_files {
-        warm_sparse_libaio_direct(fd, file_size).await
-    } else {
-        warm_full_libaio_direct(fd).await
-    };
-    
-    unsafe { libc::close(fd) };
-    result
-}
+    let path = path.clone();
+    let sparse = options.sparse_large_files > 0 && file_size > options.sparse_large_files;
+    let (block_size, stride) = options.sparse_geometry(sparse);
+    let queue_depth = options.queue_depth;
 
-#[cfg(target_os = "linux")]
-async fn warm_sparse_libaio_direct(
-    fd: libc::c_int,
-    file_size: u64,
-) -> Result<WarmingResult, std::io::Error> {
-    let start = Instant::now();
-    
-    let block_size = 4096u64; // Standard block size
-    let stride = 65536u64; // Read every 64KB
-    let mut bytes_read = 0u64;
-    
-    // Allocate aligned buffer for direct I/O
-    let layout = std::alloc::Layout::from_size_align(block_size as usize, block_size as usize)
-        .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
-    let buffer = unsafe { std::alloc::alloc(layout) };
-    if buffer.is_null() {
-        return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
-    }
-    
-    let mut offset = 0;
-    while offset < file_size {
-        // Use pread for aligned direct I/O reads
-        let result = unsafe {
-            libc::pread(fd, buffer.cast(), block_size as usize, offset as libc::off_t)
+    // io_submit/io_getevents block, so keep the loop off the async executor.
+    let bytes_read = tokio::task::spawn_blocking(move || {
+        // Open file with O_DIRECT
+        let fd = unsafe {
+            libc::open(
+                std::ffi::CString::new(path.to_string_lossy().as_ref()).unwrap().as_ptr(),
+                libc::O_RDONLY | libc::O_DIRECT,
+                0,
+            )
         };
-        
-        if result > 0 {
-            bytes_read += result as u64;
-        } else if result == 0 {
-            break; // EOF
-        } else {
-            debug!("read error at offset {}: {}", offset, std::io::Error::last_os_error());
-            // Continue with next block on error
+
+        if fd < 0 {
+            return Err(std::io::Error::last_os_error());
         }
-        
-        offset += stride;
-    }
-    
-    unsafe { 
-        std::alloc::dealloc(buffer, layout);
-    }
-    
-    debug!("Sparse libaio + direct I/O completed: {} bytes read in {:?}", bytes_read, start.elapsed());
+
+        // Only read allocated extents; holes have no S3-backed blocks.
+        let result = (|| {
+            let mut total = 0u64;
+            for (range_start, range_end) in crate::warming::extents::data_ranges(fd, file_size) {
+                total += aio_read(fd, range_start, range_end, block_size, stride, queue_depth)?;
+            }
+            Ok(total)
+        })();
+
+        unsafe { libc::close(fd) };
+        result
+    })
+    .await
+    .map_err(|e| std::io::Error::new(std::io::ErrorKind::Other, e))??;
+
+    debug!(
+        "libaio + direct I/O completed ({}): {} bytes read in {:?}",
+        if sparse { "sparse" } else { "full" },
+        bytes_read,
+        start.elapsed()
+    );
     Ok(WarmingResult {
-        method: "libaio_direct_sparse",
+        method: if sparse { "libaio_direct_sparse" } else { "libaio_direct_full" },
         success: true,
         duration: start.elapsed(),
+        bytes_read,
     })
 }
 
+/// Core AIO loop: keeps up to `queue_depth` aligned O_DIRECT reads in flight
+/// via io_submit over the byte range `[start, end)`, harvesting completions
+/// with io_getevents.
 #[cfg(target_os = "linux")]
-async fn warm_full_libaio_direct(
+pub(super) fn aio_read(
     fd: libc::c_int,
-) -> Result<WarmingResult, std::io::Error> {
-    let start = Instant::now();
-    
-    let block_size = 65536; // 64KB blocks for efficient reading
-    let mut total_bytes_read = 0u64;
-    let mut offset = 0;
-    
-    // Allocate aligned buffer for direct I/O
-    let layout = std::alloc::Layout::from_size_align(block_size, block_size)
-        .map_err(|_| std::io::Error::new(std::io::ErrorKind::Other, "Failed to create aligned memory layout"))?;
-    let buffer = unsafe { std::alloc::alloc(layout) };
-    if buffer.is_null() {
-        return Err(std::io::Error::new(std::io::ErrorKind::OutOfMemory, "Failed to allocate aligned buffer"));
+    start: u64,
+    end: u64,
+    block_size: usize,
+    stride: u64,
+    queue_depth: usize,
+) -> Result<u64, std::io::Error> {
+    // Don't build a deeper context than the range has blocks to read.
+    let blocks_needed = (end.saturating_sub(start) / stride).max(1);
+    let depth = queue_depth.max(1).min(blocks_needed as usize);
+
+    // Buffers live in THIS frame, outside the context's lifetime: if the
+    // submit/harvest loop error-returns with iocbs still in flight, the
+    // io_destroy below blocks until the kernel has completed (or cancelled)
+    // them, and only then do the buffers drop. Acquired before io_setup so
+    // an allocation failure can't leak the context.
+    let buffers: Vec<crate::warming::buffers::PooledBuffer> = (0..depth)
+        .map(|_| crate::warming::buffers::acquire(block_size))
+        .collect::<Result<_, _>>()?;
+
+    let mut ctx: AioContext = 0;
+    let rc = unsafe { libc::syscall(libc::SYS_io_setup, depth as libc::c_long, &mut ctx) };
+    if rc < 0 {
+        let e = std::io::Error::last_os_error();
+        // ENOSYS means no kernel AIO; surface as Unsupported so the strategy
+        // selector can fall through to the next tier.
+        if e.raw_os_error() == Some(libc::ENOSYS) {
+            return Err(std::io::Error::new(std::io::ErrorKind::Unsupported, "kernel AIO not supported"));
+        }
+        return Err(e);
     }
-    
+
+    let result = aio_read_with_ctx(ctx, fd, start, end, block_size, stride, &buffers);
+    unsafe { libc::syscall(libc::SYS_io_destroy, ctx) };
+    result
+}
+
+#[cfg(target_os = "linux")]
+#[allow(clippy::too_many_arguments)]
+fn aio_read_with_ctx(
+    ctx: AioContext,
+    fd: libc::c_int,
+    start: u64,
+    end: u64,
+    block_size: usize,
+    stride: u64,
+    buffers: &[crate::warming::buffers::PooledBuffer],
+) -> Result<u64, std::io::Error> {
+    let depth = buffers.len();
+    let mut iocbs: Vec<libc::iocb> = (0..depth).map(|_| unsafe { std::mem::zeroed() }).collect();
+    let mut events: Vec<IoEvent> = vec![IoEvent { data: 0, obj: 0, res: 0, res2: 0 }; depth];
+    let mut free_slots: Vec<usize> = (0..depth).collect();
+    let mut pending: Vec<*mut libc::iocb> = Vec::with_capacity(depth);
+    let mut next_offset = start;
+    let mut in_flight = 0usize;
+    let mut bytes_read = 0u64;
+
     loop {
-        // Use pread for aligned direct I/O reads
-        let result = unsafe {
-            libc::pread(fd, buffer.cast(), block_size, offset as libc::off_t)
+        // Prepare a batch of reads for every free slot.
+        pending.clear();
+        while next_offset < end {
+            let Some(slot) = free_slots.pop() else { break };
+            let iocb = &mut iocbs[slot];
+            *iocb = unsafe { std::mem::zeroed() };
+            iocb.aio_data = slot as u64;
+            iocb.aio_lio_opcode = IOCB_CMD_PREAD;
+            iocb.aio_fildes = fd as u32;
+            iocb.aio_buf = buffers[slot].as_mut_ptr() as u64;
+            iocb.aio_nbytes = block_size as u64;
+            iocb.aio_offset = next_offset as i64;
+            pending.push(iocb as *mut libc::iocb);
+            next_offset += stride;
+        }
+
+        // Submit the batch; io_submit may accept fewer than asked.
+        let mut submitted = 0usize;
+        while submitted < pending.len() {
+            let rc = unsafe {
+                libc::syscall(
+                    libc::SYS_io_submit,
+                    ctx,
+                    (pending.len() - submitted) as libc::c_long,
+                    pending.as_ptr().add(submitted),
+                )
+            };
+            if rc > 0 {
+                submitted += rc as usize;
+                in_flight += rc as usize;
+                continue;
+            }
+            let e = std::io::Error::last_os_error();
+            match e.raw_os_error() {
+                Some(libc::EINTR) => continue,
+                // Context full: harvest completions below and retry next pass.
+                Some(libc::EAGAIN) if in_flight > 0 => break,
+                _ => {
+                    debug!("io_submit failed: {}", e);
+                    return Err(e);
+                }
+            }
+        }
+        // Return slots for anything we couldn't submit this pass.
+        for &iocb_ptr in &pending[submitted..] {
+            let slot = unsafe { (*iocb_ptr).aio_data } as usize;
+            free_slots.push(slot);
+            next_offset -= stride;
+        }
+
+        if in_flight == 0 {
+            break;
+        }
+
+        // Block until at least one completion is ready, then drain.
+        let harvested = unsafe {
+            libc::syscall(
+                libc::SYS_io_getevents,
+                ctx,
+                1 as libc::c_long,
+                depth as libc::c_long,
+                events.as_mut_ptr(),
+                std::ptr::null::<libc::timespec>(),
+            )
         };
-        
-        if result > 0 {
-            total_bytes_read += result as u64;
-            offset += result;
-        } else if result == 0 {
-            break; // EOF
-        } else {
-            unsafe { 
-                std::alloc::dealloc(buffer, layout);
+        if harvested < 0 {
+            let e = std::io::Error::last_os_error();
+            if e.raw_os_error() == Some(libc::EINTR) {
+                continue;
+            }
+            debug!("io_getevents failed: {}", e);
+            return Err(e);
+        }
+
+        for event in &events[..harvested as usize] {
+            in_flight -= 1;
+            free_slots.push(event.data as usize);
+            if event.res > 0 {
+                bytes_read += event.res as u64;
+            } else if event.res < 0 {
+                debug!("libaio read error: {}", std::io::Error::from_raw_os_error(-event.res as i32));
+                // Continue with remaining blocks on error
             }
-            return Err(std::io::Error::last_os_error());
         }
     }
-    
-    unsafe { 
-        std::alloc::dealloc(buffer, layout);
-    }
-    
-    debug!("Full libaio + direct I/O completed: {} bytes read in {:?}", total_bytes_read, start.elapsed());
-    Ok(WarmingResult {
-        method: "libaio_direct_full",
-        success: true,
-        duration: start.elapsed(),
-    })
+
+    Ok(bytes_read)
 }
 
 // Stub implementation for non-Linux systems
@@ -169,4 +266,4 @@ pub async fn warm_file(
         std::io::ErrorKind::Unsupported,
         "libaio only supported on Linux"
     ))
-} 
\ No newline at end of file
+}
@@ -0,0 +1,178 @@
+//! Warm manifests: what a finished run hydrated, so the next run can diff.
+//!
+//! Nightly incremental snapshot restores change a few percent of blocks,
+//! but without a record of the previous warm the tool re-reads everything.
+//! `--emit-manifest` writes one fixed-size binary record per successfully
+//! warmed file - dev, inode, size, mtime, the same 32-byte little-endian
+//! layout as the checkpoint log, flat and mmap-friendly. `--since` loads
+//! such a manifest and diffs each discovered file against it: unchanged
+//! files are skipped, files that only grew warm just the appended tail,
+//! and anything else (new, shrunk, rewritten) warms in full. Files the
+//! diff skips are still recorded into the next manifest, so a nightly
+//! `--since last --emit-manifest next` chain describes the whole warm set,
+//! not just the files each run touched. Size+mtime is the metadata
+//! checksum; a touched-but-identical file re-warms, which costs time but
+//! never coverage.
+
+use std::collections::HashMap;
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+
+use log::debug;
+
+use crate::warming::checkpoint::{FileKey, RECORD_SIZE};
+
+/// How a discovered file compares to its entry in the previous manifest.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Diff {
+    /// Same size and mtime: blocks already hydrated by the previous run.
+    Unchanged,
+    /// The file only grew; warm from the previous size to the end.
+    Grown { from: u64 },
+    /// New, shrunk, or rewritten: warm in full.
+    Changed,
+}
+
+/// A loaded `--since` manifest, keyed by (dev, inode).
+pub struct Manifest {
+    entries: HashMap<(u64, u64), (u64, i64)>,
+}
+
+impl Manifest {
+    /// Load a manifest written by `--emit-manifest`. Same torn-record
+    /// tolerance as the checkpoint log.
+    pub fn load(path: &Path) -> Result<Manifest, std::io::Error> {
+        let data = std::fs::read(path)?;
+        if data.len() % RECORD_SIZE != 0 {
+            debug!(
+                "Manifest has {} trailing bytes from an interrupted write, ignoring",
+                data.len() % RECORD_SIZE
+            );
+        }
+        let mut entries = HashMap::with_capacity(data.len() / RECORD_SIZE);
+        for record in data.chunks_exact(RECORD_SIZE) {
+            let key = FileKey::from_bytes(record);
+            entries.insert((key.dev, key.ino), (key.size, key.mtime));
+        }
+        debug!("Loaded {} manifest entries from {}", entries.len(), path.display());
+        Ok(Manifest { entries })
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    /// Diff one discovered file against the manifest.
+    pub fn diff(&self, key: &FileKey) -> Diff {
+        match self.entries.get(&(key.dev, key.ino)) {
+            Some(&(size, mtime)) if size == key.size && mtime == key.mtime => Diff::Unchanged,
+            // Append-only growth: mtime moves on append, so only the size
+            // relation matters. The already-warmed prefix stays skipped.
+            Some(&(size, _)) if size < key.size => Diff::Grown { from: size },
+            Some(_) => Diff::Changed,
+            None => Diff::Changed,
+        }
+    }
+}
+
+/// Collects the keys of successfully warmed files and writes the manifest
+/// once at the end of the run. No batched-fsync thread like the checkpoint
+/// writer: the manifest is only useful complete, so a crashed run simply
+/// leaves the previous one in place.
+#[derive(Debug, Default)]
+pub struct ManifestWriter {
+    keys: Mutex<Vec<FileKey>>,
+}
+
+impl ManifestWriter {
+    pub fn new() -> Self {
+        ManifestWriter::default()
+    }
+
+    pub fn record(&self, key: FileKey) {
+        self.keys.lock().unwrap().push(key);
+    }
+
+    /// Write all collected records, replacing any previous manifest.
+    /// Returns the record count.
+    pub fn write(&self, path: &Path) -> Result<usize, std::io::Error> {
+        let keys = self.keys.lock().unwrap();
+        let mut file = std::fs::File::create(path)?;
+        for key in keys.iter() {
+            file.write_all(&key.to_bytes())?;
+        }
+        file.sync_all()?;
+        Ok(keys.len())
+    }
+}
+
+/// Warm only `[start, file_size)` of a grown file: aligned O_DIRECT reads
+/// of the appended tail, leaving the already-hydrated prefix untouched.
+#[cfg(target_os = "linux")]
+pub async fn warm_tail(
+    path: &PathBuf,
+    start: u64,
+    file_size: u64,
+    _options: &crate::warming::WarmingOptions,
+) -> Result<crate::warming::WarmingResult, std::io::Error> {
+    use std::os::unix::fs::OpenOptionsExt;
+    use std::os::unix::prelude::AsRawFd;
+
+    let began = std::time::Instant::now();
+    let file = std::fs::OpenOptions::new()
+        .read(true)
+        .custom_flags(libc::O_DIRECT)
+        .open(path)?;
+
+    let bytes_read = tokio::task::spawn_blocking(move || {
+        const ALIGNMENT: u64 = 4096;
+        let block_size = crate::warming::buffers::POOL_BLOCK_SIZE;
+        let buffer = crate::warming::buffers::acquire(block_size)?;
+        let fd = file.as_raw_fd();
+        let mut offset = start / ALIGNMENT * ALIGNMENT;
+        let mut total = 0u64;
+        while offset < file_size {
+            let rc = unsafe {
+                libc::pread(fd, buffer.as_mut_ptr().cast(), block_size, offset as libc::off_t)
+            };
+            match rc {
+                0 => break,
+                n if n > 0 => {
+                    total += n as u64;
+                    offset += n as u64;
+                }
+                _ => return Err(std::io::Error::last_os_error()),
+            }
+        }
+        Ok(total)
+    })
+    .await
+    .map_err(|e| std::io::Error::new(std::io::ErrorKind::Other, e))??;
+
+    Ok(crate::warming::WarmingResult {
+        method: "manifest_tail",
+        success: true,
+        duration: began.elapsed(),
+        bytes_read,
+    })
+}
+
+// Stub implementation for non-Linux systems: no O_DIRECT range reads, so
+// the caller falls back to warming the whole file.
+#[cfg(not(target_os = "linux"))]
+pub async fn warm_tail(
+    _path: &PathBuf,
+    _start: u64,
+    _file_size: u64,
+    _options: &crate::warming::WarmingOptions,
+) -> Result<crate::warming::WarmingResult, std::io::Error> {
+    Err(std::io::Error::new(
+        std::io::ErrorKind::Unsupported,
+        "tail warming only supported on Linux",
+    ))
+}
@@ -1,8 +1,22 @@
 use std::path::PathBuf;
 use log::debug;
 
+pub mod adaptive;
+pub mod buffers;
+#[cfg(target_os = "linux")]
+pub mod cache_drop;
+pub mod checkpoint;
+pub mod device;
+#[cfg(target_os = "linux")]
+pub mod extents;
 pub mod fallback;
+pub mod manifest;
+pub mod metrics;
+pub mod residency;
+pub mod statx;
+pub mod throttle;
 pub mod tokio_async;
+pub mod verify;
 
 #[cfg(target_os = "linux")]
 pub mod libaio;
@@ -10,6 +24,12 @@ pub mod libaio;
 #[cfg(target_os = "linux")]
 pub mod io_uring;
 
+#[cfg(target_os = "linux")]
+pub mod engine;
+
+#[cfg(target_os = "linux")]
+pub mod per_core;
+
 /// Warming strategy options
 #[derive(Debug, Clone)]
 pub struct WarmingOptions {
@@ -17,6 +37,61 @@ pub struct WarmingOptions {
     pub use_libaio: bool,
     pub use_direct_io: bool,
     pub sparse_large_files: u64,
+    pub queue_depth: usize,
+    /// Pick a strategy per file by size class instead of one global strategy.
+    pub auto_strategy: bool,
+    /// Files at or below this size go through the batched ring path.
+    pub small_file_threshold: u64,
+    /// Files at or above this size get sparse O_DIRECT sampling.
+    pub huge_file_threshold: u64,
+    /// Files at or above this size are split into ranges warmed in parallel
+    /// (0 disables).
+    pub range_parallel_threshold: u64,
+    /// Probe sampled offsets with preadv2(RWF_NOWAIT) and skip files whose
+    /// data is already resident, for cheap incremental re-warms.
+    pub skip_resident: bool,
+    /// Bytes read at each sparse sample point.
+    pub sparse_read_size: usize,
+    /// Distance between sparse sample points. Defaults to the 512KiB EBS
+    /// snapshot block size: one read per snapshot block hydrates everything.
+    pub sparse_stride: u64,
+    /// Shared long-lived io_uring engine; when present, io_uring warming
+    /// goes through it instead of building per-file rings.
+    #[cfg(target_os = "linux")]
+    pub uring_engine: Option<std::sync::Arc<engine::UringEngine>>,
+    /// Deferred cache-drop worker: fadvise warming hands warmed files here
+    /// so DONTNEED waits for the readahead to actually land.
+    #[cfg(target_os = "linux")]
+    pub cache_dropper: Option<std::sync::Arc<cache_drop::CacheDropper>>,
+}
+
+impl WarmingOptions {
+    /// Read size and stride for the given mode: configured sparse geometry
+    /// when sampling, full 64KB blocks back-to-back otherwise.
+    #[cfg(target_os = "linux")]
+    pub fn sparse_geometry(&self, sparse: bool) -> (usize, u64) {
+        if sparse {
+            // O_DIRECT requires sector alignment; round the read size up.
+            let block = self.sparse_read_size.max(1).div_ceil(4096) * 4096;
+            (block, self.sparse_stride.max(block as u64))
+        } else {
+            (io_uring::FULL_BLOCK_SIZE, io_uring::FULL_BLOCK_SIZE as u64)
+        }
+    }
+}
+
+/// Sort key for physical-order scheduling: the on-disk address of the
+/// file's first extent. Files that can't be mapped sort to the back.
+pub fn physical_sort_key(path: &PathBuf) -> u64 {
+    #[cfg(target_os = "linux")]
+    {
+        extents::physical_offset(path).unwrap_or(u64::MAX)
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        let _ = path;
+        u64::MAX
+    }
 }
 
 /// Result of a warming operation
@@ -25,6 +100,9 @@ pub struct WarmingResult {
     pub method: &'static str,
     pub success: bool,
     pub duration: std::time::Duration,
+    /// Actual bytes read (or requested via hints) by the strategy, used for
+    /// throughput accounting and throttling.
+    pub bytes_read: u64,
 }
 
 /// Main warming function that selects the best strategy
@@ -34,7 +112,45 @@ pub async fn warm_file(
     options: &WarmingOptions,
 ) -> Result<WarmingResult, std::io::Error> {
     let _start = std::time::Instant::now();
-    
+
+    // Incremental re-warm: skip files whose sampled blocks are already
+    // resident, falling through to real reads when any sample is cold or
+    // the kernel lacks RWF_NOWAIT.
+    if options.skip_resident {
+        match residency::is_resident(path, file_size).await {
+            Ok(true) => {
+                debug!("Skipping resident file: {}", path.display());
+                return Ok(WarmingResult {
+                    method: "resident_skip",
+                    success: true,
+                    duration: _start.elapsed(),
+                    bytes_read: 0,
+                });
+            }
+            Ok(false) => {}
+            Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {
+                debug!("Residency probing unavailable: {}", e);
+            }
+            Err(e) => {
+                debug!("Residency probe failed for {}: {}", path.display(), e);
+            }
+        }
+    }
+
+    // Huge files get split into independent ranges warmed concurrently, so
+    // one 200GB file can keep the whole queue depth busy by itself instead
+    // of trickling through a single sequential stream.
+    #[cfg(target_os = "linux")]
+    if options.range_parallel_threshold > 0 && file_size >= options.range_parallel_threshold {
+        return warm_file_range_parallel(path, file_size, options).await;
+    }
+
+    // Size-class dispatch: our trees are bimodal (millions of tiny files
+    // plus a few multi-GB ones), and no single strategy fits both shapes.
+    if options.auto_strategy {
+        return warm_file_auto(path, file_size, options).await;
+    }
+
     // Strategy selection priority:
     // 1. io_uring (if available and requested)
     // 2. libaio (if available and requested)
@@ -71,7 +187,7 @@ pub async fn warm_file(
     
     // Try OS hints first (most efficient)
     debug!("Trying OS hints (fadvise/madvise) for {}", path.display());
-    if let Ok(result) = fallback::warm_with_os_hints(path, file_size).await {
+    if let Ok(result) = fallback::warm_with_os_hints(path, file_size, options).await {
         if result.success {
             return Ok(result);
         }
@@ -80,4 +196,220 @@ pub async fn warm_file(
     // Fallback to Tokio async I/O
     debug!("Using Tokio async I/O for {}", path.display());
     tokio_async::warm_file(path, file_size, options).await
+}
+
+/// Warm one huge file by splitting it into independent byte ranges and
+/// dispatching them concurrently, each range driving its own ring or AIO
+/// context. Holes are skipped per range via the extent map.
+#[cfg(target_os = "linux")]
+async fn warm_file_range_parallel(
+    path: &PathBuf,
+    file_size: u64,
+    options: &WarmingOptions,
+) -> Result<WarmingResult, std::io::Error> {
+    let start = std::time::Instant::now();
+
+    // This check runs before the size-class dispatch, so it must honor the
+    // same promise warm_file_auto makes: huge files under --auto-strategy
+    // get sparse O_DIRECT sampling, not a full read of every byte.
+    let sparse = (options.sparse_large_files > 0 && file_size > options.sparse_large_files)
+        || (options.auto_strategy
+            && options.huge_file_threshold > 0
+            && file_size >= options.huge_file_threshold);
+    let (block_size, stride) = options.sparse_geometry(sparse);
+
+    // Enough ranges to fill the queue depth, without drowning in tiny spans.
+    let range_count = (options.queue_depth / 8).clamp(2, 32) as u64;
+    let span = (file_size / range_count).max(stride);
+    // Keep range boundaries stride-aligned so reads don't overlap.
+    let span = span.div_ceil(stride) * stride;
+    let depth_per_range = (options.queue_depth / range_count as usize).max(8);
+
+    let use_io_uring = options.use_io_uring || options.auto_strategy;
+    let use_libaio = options.use_libaio;
+    let use_direct_io = options.use_direct_io || sparse;
+
+    let mut tasks = Vec::new();
+    let mut range_start = 0u64;
+    while range_start < file_size {
+        let range_end = (range_start + span).min(file_size);
+        let path = path.clone();
+        tasks.push(tokio::task::spawn_blocking(move || {
+            warm_range_blocking(
+                &path, range_start, range_end, block_size, stride, depth_per_range,
+                use_io_uring, use_libaio, use_direct_io,
+            )
+        }));
+        range_start = range_end;
+    }
+
+    let mut total_bytes = 0u64;
+    let mut first_error: Option<std::io::Error> = None;
+    for task in tasks {
+        match task.await.map_err(|e| std::io::Error::new(std::io::ErrorKind::Other, e))? {
+            Ok(bytes) => total_bytes += bytes,
+            Err(e) => {
+                debug!("Range warming failed for {}: {}", path.display(), e);
+                first_error.get_or_insert(e);
+            }
+        }
+    }
+
+    if total_bytes == 0 {
+        if let Some(e) = first_error {
+            return Err(e);
+        }
+    }
+
+    debug!(
+        "Range-parallel warming completed: {} bytes of {} in {:?}",
+        total_bytes, path.display(), start.elapsed()
+    );
+    Ok(WarmingResult {
+        method: if sparse { "range_parallel_sparse" } else { "range_parallel_full" },
+        success: true,
+        duration: start.elapsed(),
+        bytes_read: total_bytes,
+    })
+}
+
+/// Warm one byte range of a file with the best available async machinery.
+/// Runs on the blocking pool; opens its own descriptor so ranges don't
+/// contend on shared file state.
+#[cfg(target_os = "linux")]
+#[allow(clippy::too_many_arguments)]
+fn warm_range_blocking(
+    path: &PathBuf,
+    range_start: u64,
+    range_end: u64,
+    block_size: usize,
+    stride: u64,
+    queue_depth: usize,
+    use_io_uring: bool,
+    use_libaio: bool,
+    use_direct_io: bool,
+) -> Result<u64, std::io::Error> {
+    use std::os::unix::ffi::OsStrExt;
+    let cpath = std::ffi::CString::new(path.as_os_str().as_bytes())
+        .map_err(|_| std::io::Error::new(std::io::ErrorKind::InvalidInput, "path contains NUL byte"))?;
+    let open_flags = libc::O_RDONLY | if use_direct_io { libc::O_DIRECT } else { 0 };
+    let fd = unsafe { libc::open(cpath.as_ptr(), open_flags, 0) };
+    if fd < 0 {
+        return Err(std::io::Error::last_os_error());
+    }
+
+    let result = (|| {
+        // Intersect the assigned range with the file's allocated extents.
+        let mut total = 0u64;
+        for (data_start, data_end) in extents::data_ranges(fd, range_end) {
+            let start = data_start.max(range_start);
+            let end = data_end.min(range_end);
+            if start >= end {
+                continue;
+            }
+            if use_io_uring {
+                match io_uring::ring_read(fd, start, end, block_size, stride, queue_depth) {
+                    Ok(bytes) => {
+                        total += bytes;
+                        continue;
+                    }
+                    Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {}
+                    Err(e) => return Err(e),
+                }
+            }
+            if use_libaio {
+                match libaio::aio_read(fd, start, end, block_size, stride, queue_depth) {
+                    Ok(bytes) => {
+                        total += bytes;
+                        continue;
+                    }
+                    Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {}
+                    Err(e) => return Err(e),
+                }
+            }
+            // Synchronous fallback for this range.
+            let buffer = buffers::acquire(block_size)?;
+            let mut offset = start;
+            while offset < end {
+                let rc = unsafe { libc::pread(fd, buffer.as_mut_ptr().cast(), block_size, offset as libc::off_t) };
+                if rc > 0 {
+                    total += rc as u64;
+                } else if rc == 0 {
+                    break;
+                } else {
+                    return Err(std::io::Error::last_os_error());
+                }
+                offset += stride;
+            }
+        }
+        Ok(total)
+    })();
+
+    // Without O_DIRECT the reads above (ring, AIO, or pread) went through
+    // the page cache; drop it before closing - we only wanted the EBS
+    // warming, not OS caching. All reads have completed, so no grace period.
+    if !use_direct_io {
+        unsafe { libc::posix_fadvise(fd, 0, 0, libc::POSIX_FADV_DONTNEED) };
+    }
+    unsafe { libc::close(fd) };
+    result
+}
+
+/// Per-file strategy selection by size class:
+/// - tiny/small files: batched open+read through the shared io_uring engine,
+///   where per-file syscall overhead dominates;
+/// - medium files: fadvise readahead hints, cheapest way to trigger the fetch;
+/// - huge files: sparse O_DIRECT sampling, one read per EBS block is enough.
+async fn warm_file_auto(
+    path: &PathBuf,
+    file_size: u64,
+    options: &WarmingOptions,
+) -> Result<WarmingResult, std::io::Error> {
+    if file_size <= options.small_file_threshold {
+        #[cfg(target_os = "linux")]
+        {
+            debug!("Auto strategy: small file, using io_uring for {}", path.display());
+            match io_uring::warm_file(path, file_size, options).await {
+                Ok(result) => return Ok(result),
+                Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {
+                    debug!("io_uring not available for small file: {}", e);
+                }
+                Err(e) => return Err(e),
+            }
+        }
+    } else if options.huge_file_threshold > 0 && file_size >= options.huge_file_threshold {
+        debug!("Auto strategy: huge file, using sparse direct I/O for {}", path.display());
+        let mut sparse_options = options.clone();
+        sparse_options.use_direct_io = true;
+        // Any non-zero threshold below file_size forces the sparse path.
+        sparse_options.sparse_large_files = 1;
+
+        #[cfg(target_os = "linux")]
+        {
+            match io_uring::warm_file(path, file_size, &sparse_options).await {
+                Ok(result) => return Ok(result),
+                Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {
+                    debug!("io_uring not available for huge file: {}", e);
+                }
+                Err(e) => return Err(e),
+            }
+            match libaio::warm_file(path, file_size, &sparse_options).await {
+                Ok(result) => return Ok(result),
+                Err(e) if e.kind() == std::io::ErrorKind::Unsupported => {
+                    debug!("libaio not available for huge file: {}", e);
+                }
+                Err(e) => return Err(e),
+            }
+        }
+        return tokio_async::warm_file(path, file_size, &sparse_options).await;
+    }
+
+    // Medium files (and small-file fallback): OS hints, then Tokio.
+    debug!("Auto strategy: using OS hints for {}", path.display());
+    if let Ok(result) = fallback::warm_with_os_hints(path, file_size, options).await {
+        if result.success {
+            return Ok(result);
+        }
+    }
+    tokio_async::warm_file(path, file_size, options).await
 } 
\ No newline at end of file
@@ -0,0 +1,222 @@
+//! Thread-per-core warming engine built on tokio-uring.
+//!
+//! The default pipeline runs on the multi-threaded tokio runtime, whose work
+//! stealing bounces small-file tasks between cores. For tiny-file-dominated
+//! trees this mode (`--engine thread-per-core`) pins one tokio-uring runtime
+//! per core instead — each with its own ring, buffers, and plain (non-atomic)
+//! counters — and shards files across cores by path hash, so the per-file
+//! hot path never crosses a core boundary. Totals are aggregated once at the
+//! end when the workers join.
+
+use std::collections::hash_map::DefaultHasher;
+use std::hash::{Hash, Hasher};
+use std::path::PathBuf;
+use std::rc::Rc;
+use std::sync::Arc;
+
+use log::debug;
+use tokio::sync::mpsc;
+
+use crate::warming::checkpoint::{CheckpointWriter, FileKey};
+use crate::warming::WarmingOptions;
+
+/// A file routed to a core worker.
+pub struct Job {
+    pub path: PathBuf,
+    pub size: u64,
+    pub key: Option<FileKey>,
+}
+
+/// Totals a single core accumulated without any cross-core traffic.
+#[derive(Debug, Default, Clone, Copy)]
+pub struct CoreStats {
+    pub files: u64,
+    pub bytes: u64,
+    pub errors: u64,
+}
+
+/// Per-worker configuration snapshot (everything the hot path needs, no
+/// shared WarmingOptions borrow).
+#[derive(Clone)]
+struct WorkerConfig {
+    depth: usize,
+    sparse_large_files: u64,
+    block_size: usize,
+    sparse_read_size: usize,
+    sparse_stride: u64,
+    checkpoint: Option<Arc<CheckpointWriter>>,
+    progress: indicatif::ProgressBar,
+}
+
+/// Files are sharded across workers; each worker owns one tokio-uring
+/// runtime on its own thread.
+pub struct ShardedWarmer {
+    senders: Vec<mpsc::Sender<Job>>,
+    handles: Vec<std::thread::JoinHandle<CoreStats>>,
+}
+
+impl ShardedWarmer {
+    pub fn start(
+        workers: usize,
+        options: &WarmingOptions,
+        checkpoint: Option<Arc<CheckpointWriter>>,
+        progress: indicatif::ProgressBar,
+    ) -> Result<Self, std::io::Error> {
+        let workers = workers.max(1);
+        // Split the requested depth across cores like the shared engine does.
+        let depth = (options.queue_depth / workers).max(4);
+        let (sparse_read_size, sparse_stride) = options.sparse_geometry(true);
+        let config = WorkerConfig {
+            depth,
+            sparse_large_files: options.sparse_large_files,
+            block_size: crate::warming::io_uring::FULL_BLOCK_SIZE,
+            sparse_read_size,
+            sparse_stride,
+            checkpoint,
+            progress,
+        };
+
+        let mut senders = Vec::with_capacity(workers);
+        let mut handles = Vec::with_capacity(workers);
+        for core in 0..workers {
+            // Bounded: enough queued jobs to keep the core busy between
+            // dispatch wakeups, but small enough that a slow core pushes
+            // back through dispatch to the walkers instead of buffering
+            // millions of queued paths in RSS.
+            let (tx, rx) = mpsc::channel::<Job>(depth * 2);
+            let config = config.clone();
+            let handle = std::thread::Builder::new()
+                .name(format!("warm-core-{}", core))
+                .spawn(move || tokio_uring::start(core_loop(rx, config)))?;
+            senders.push(tx);
+            handles.push(handle);
+        }
+        debug!("thread-per-core engine started: {} cores, depth {} each", workers, depth);
+        Ok(ShardedWarmer { senders, handles })
+    }
+
+    /// Route one file to its core. The shard is a pure function of the path
+    /// so reruns place files identically. Awaits while the core's queue is
+    /// full, so walker backpressure reaches this mode too.
+    pub async fn dispatch(&self, job: Job) {
+        let mut hasher = DefaultHasher::new();
+        job.path.hash(&mut hasher);
+        let core = (hasher.finish() as usize) % self.senders.len();
+        // A closed channel means the worker died; the job is counted as an
+        // error when stats are aggregated (its files simply stay cold).
+        let _ = self.senders[core].send(job).await;
+    }
+
+    /// Close all shards and wait for the workers to drain. Returns the
+    /// aggregated totals.
+    pub async fn finish(self) -> CoreStats {
+        drop(self.senders);
+        tokio::task::spawn_blocking(move || {
+            let mut total = CoreStats::default();
+            for handle in self.handles {
+                if let Ok(stats) = handle.join() {
+                    debug!("core worker done: {} files, {} bytes, {} errors", stats.files, stats.bytes, stats.errors);
+                    total.files += stats.files;
+                    total.bytes += stats.bytes;
+                    total.errors += stats.errors;
+                }
+            }
+            total
+        })
+        .await
+        .unwrap_or_default()
+    }
+}
+
+/// One core's event loop: admit files from the shard channel, keep up to
+/// `depth` of them in flight on this core's ring.
+async fn core_loop(mut rx: mpsc::Receiver<Job>, config: WorkerConfig) -> CoreStats {
+    let semaphore = Arc::new(tokio::sync::Semaphore::new(config.depth));
+    // Single-threaded runtime: plain Cell counters, no atomics.
+    let stats = Rc::new(std::cell::Cell::new(CoreStats::default()));
+    let config = Rc::new(config);
+
+    while let Some(job) = rx.recv().await {
+        let permit = semaphore.clone().acquire_owned().await.unwrap();
+        let stats = Rc::clone(&stats);
+        let config = Rc::clone(&config);
+        tokio_uring::spawn(async move {
+            let outcome = warm_one(&job, &config).await;
+            // Read-modify-write only after the await: tasks interleave at
+            // suspension points, and a stale snapshot would lose updates.
+            let mut current = stats.get();
+            match outcome {
+                Ok(bytes) => {
+                    current.bytes += bytes;
+                    if let (Some(writer), Some(key)) = (&config.checkpoint, job.key) {
+                        writer.record(key);
+                    }
+                }
+                Err(e) => {
+                    debug!("Failed to warm file {}: {}", job.path.display(), e);
+                    current.errors += 1;
+                }
+            }
+            current.files += 1;
+            stats.set(current);
+            // Batch progress updates; the bar is the one shared structure.
+            if current.files % 64 == 0 {
+                config.progress.inc(64);
+            }
+            drop(permit);
+        });
+    }
+
+    // Drain: reclaim every permit so all spawned reads have finished.
+    let _ = semaphore.acquire_many(config.depth as u32).await.unwrap();
+    let final_stats = stats.get();
+    config.progress.inc(final_stats.files % 64);
+    final_stats
+}
+
+/// Warm one file on this core's ring: buffered reads of allocated extents,
+/// sparse-sampled above the threshold, then drop the pages from cache.
+async fn warm_one(job: &Job, config: &WorkerConfig) -> Result<u64, std::io::Error> {
+    let file = tokio_uring::fs::File::open(&job.path).await?;
+
+    let sparse = config.sparse_large_files > 0 && job.size > config.sparse_large_files;
+    let (block_size, stride) = if sparse {
+        (config.sparse_read_size, config.sparse_stride)
+    } else {
+        (config.block_size, config.block_size as u64)
+    };
+
+    // Only read allocated extents; holes have no S3-backed blocks.
+    let ranges = {
+        use std::os::unix::io::AsRawFd;
+        crate::warming::extents::data_ranges(file.as_raw_fd(), job.size)
+    };
+
+    let mut buf = vec![0u8; block_size];
+    let mut total = 0u64;
+    'ranges: for (range_start, range_end) in ranges {
+        let mut offset = range_start;
+        while offset < range_end {
+            let (result, returned) = file.read_at(buf, offset).await;
+            buf = returned;
+            match result {
+                Ok(0) => break 'ranges,
+                Ok(n) => total += n as u64,
+                Err(e) => {
+                    debug!("read failed at offset {} in {}: {}", offset, job.path.display(), e);
+                    break 'ranges;
+                }
+            }
+            offset += stride;
+        }
+    }
+
+    // Buffered reads populated the page cache; we only wanted EBS warming.
+    {
+        use nix::fcntl::{posix_fadvise, PosixFadviseAdvice};
+        use std::os::unix::io::AsRawFd;
+        let _ = posix_fadvise(file.as_raw_fd(), 0, job.size as i64, PosixFadviseAdvice::POSIX_FADV_DONTNEED);
+    }
+    let _ = file.close().await;
+    Ok(total)
+}
@@ -0,0 +1,111 @@
+use std::path::PathBuf;
+
+use log::debug;
+
+#[cfg(target_os = "linux")]
+use libc;
+
+/// Residency probing for incremental re-warms: before reading a file, sample
+/// a handful of offsets with `preadv2(RWF_NOWAIT)`. The kernel returns the
+/// data only if it can be served without blocking (already in the page
+/// cache); a cold block fails fast with EAGAIN. Files whose samples all come
+/// back warm are skipped, turning a re-run over mostly-hydrated data into a
+/// metadata-speed pass.
+
+/// Bytes probed per sample. One page is enough to prove residency.
+#[cfg(target_os = "linux")]
+const PROBE_SIZE: usize = 4096;
+
+/// Maximum samples per file; spread evenly so large files are probed at
+/// several points, not just the head.
+#[cfg(target_os = "linux")]
+const MAX_PROBES: u64 = 8;
+
+/// Probe whether `path` is already resident. Returns Ok(true) when every
+/// sampled offset was served without blocking, Ok(false) when any sample
+/// was cold, and ErrorKind::Unsupported when the kernel (pre-4.14) or the
+/// filesystem doesn't implement RWF_NOWAIT so the caller warms normally.
+#[cfg(target_os = "linux")]
+pub async fn is_resident(path: &PathBuf, file_size: u64) -> Result<bool, std::io::Error> {
+    if file_size == 0 {
+        return Ok(true);
+    }
+    let path = path.clone();
+    // The probes never block on I/O by construction, but open() on a cold
+    // directory can, so keep the whole thing off the async executor.
+    tokio::task::spawn_blocking(move || probe_path(&path, file_size))
+        .await
+        .map_err(|e| std::io::Error::new(std::io::ErrorKind::Other, e))?
+}
+
+/// Blocking residency probe, for callers already on a dedicated thread
+/// (e.g. the deferred cache-drop worker).
+#[cfg(target_os = "linux")]
+pub(super) fn probe_path(path: &std::path::Path, file_size: u64) -> Result<bool, std::io::Error> {
+    use std::os::unix::ffi::OsStrExt;
+    if file_size == 0 {
+        return Ok(true);
+    }
+    let cpath = std::ffi::CString::new(path.as_os_str().as_bytes())
+        .map_err(|_| std::io::Error::new(std::io::ErrorKind::InvalidInput, "path contains NUL byte"))?;
+    let fd = unsafe { libc::open(cpath.as_ptr(), libc::O_RDONLY, 0) };
+    if fd < 0 {
+        return Err(std::io::Error::last_os_error());
+    }
+    let result = probe_fd(fd, file_size);
+    unsafe { libc::close(fd) };
+    result
+}
+
+#[cfg(target_os = "linux")]
+fn probe_fd(fd: libc::c_int, file_size: u64) -> Result<bool, std::io::Error> {
+    let probes = (file_size.div_ceil(PROBE_SIZE as u64)).min(MAX_PROBES);
+    // Even spacing across the file, page-aligned; always includes offset 0.
+    let step = (file_size / probes).max(PROBE_SIZE as u64) / PROBE_SIZE as u64
+        * PROBE_SIZE as u64;
+
+    let mut buf = [0u8; PROBE_SIZE];
+    for i in 0..probes {
+        let offset = (i * step).min(file_size.saturating_sub(1)) / PROBE_SIZE as u64
+            * PROBE_SIZE as u64;
+        let iov = libc::iovec {
+            iov_base: buf.as_mut_ptr().cast(),
+            iov_len: PROBE_SIZE.min((file_size - offset) as usize),
+        };
+        let rc = unsafe { libc::preadv2(fd, &iov, 1, offset as libc::off_t, libc::RWF_NOWAIT) };
+        if rc > 0 {
+            continue;
+        }
+        if rc == 0 {
+            // Read past the (possibly shrunk) end of file: nothing left cold.
+            return Ok(true);
+        }
+        let e = std::io::Error::last_os_error();
+        match e.raw_os_error() {
+            // Cold block: the kernel would have to block to serve this read.
+            Some(libc::EAGAIN) => {
+                debug!("Residency probe cold at offset {}", offset);
+                return Ok(false);
+            }
+            Some(libc::EINTR) => return Ok(false),
+            // Kernel or filesystem without RWF_NOWAIT support.
+            Some(libc::ENOSYS) | Some(libc::EOPNOTSUPP) | Some(libc::EINVAL) => {
+                return Err(std::io::Error::new(
+                    std::io::ErrorKind::Unsupported,
+                    "preadv2(RWF_NOWAIT) not supported",
+                ));
+            }
+            _ => return Err(e),
+        }
+    }
+    Ok(true)
+}
+
+// Stub implementation for non-Linux systems
+#[cfg(not(target_os = "linux"))]
+pub async fn is_resident(_path: &PathBuf, _file_size: u64) -> Result<bool, std::io::Error> {
+    Err(std::io::Error::new(
+        std::io::ErrorKind::Unsupported,
+        "residency probing only supported on Linux",
+    ))
+}
@@ -0,0 +1,116 @@
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+
+use log::debug;
+
+/// Token-bucket rate limiter shared across warming tasks, capping bandwidth
+/// (bytes/sec) and IOPS so a warming run doesn't starve co-resident
+/// production traffic of EBS throughput.
+///
+/// Accounting is post-paid: a task waits until the bucket is non-negative,
+/// runs its warming I/O, then charges the *actual* bytes and operations it
+/// performed. The bucket may go negative after a large file, which simply
+/// pushes the next waiter's release time out — over any window longer than a
+/// couple of files, sustained throughput converges on the configured rate
+/// without needing to predict per-file cost up front.
+#[derive(Debug)]
+pub struct Throttle {
+    /// Bytes added to the bucket per second (0 = unlimited).
+    bytes_per_sec: u64,
+    /// Operations added to the bucket per second (0 = unlimited).
+    ops_per_sec: u64,
+    state: Mutex<BucketState>,
+}
+
+#[derive(Debug)]
+struct BucketState {
+    /// May go negative after a large charge; refilled lazily on access.
+    byte_tokens: i64,
+    op_tokens: i64,
+    last_refill: Instant,
+}
+
+impl Throttle {
+    /// Build a throttle from the CLI limits. Returns None when neither limit
+    /// is set so the hot path can skip throttling entirely.
+    pub fn from_limits(bytes_per_sec: u64, ops_per_sec: u64) -> Option<Self> {
+        if bytes_per_sec == 0 && ops_per_sec == 0 {
+            return None;
+        }
+        Some(Throttle {
+            bytes_per_sec,
+            ops_per_sec,
+            state: Mutex::new(BucketState {
+                // Start with one second of burst so the pipeline fills
+                // immediately instead of trickling up from zero.
+                byte_tokens: bytes_per_sec as i64,
+                op_tokens: ops_per_sec as i64,
+                last_refill: Instant::now(),
+            }),
+        })
+    }
+
+    /// Wait until the bucket is out of debt. Called before each file is
+    /// warmed; the Mutex is never held across an await point.
+    pub async fn wait_ready(&self) {
+        loop {
+            let sleep_for = {
+                let mut state = self.state.lock().unwrap();
+                self.refill(&mut state);
+
+                let byte_wait = if self.bytes_per_sec > 0 && state.byte_tokens < 0 {
+                    Self::time_to_repay(-state.byte_tokens, self.bytes_per_sec)
+                } else {
+                    Duration::ZERO
+                };
+                let op_wait = if self.ops_per_sec > 0 && state.op_tokens < 0 {
+                    Self::time_to_repay(-state.op_tokens, self.ops_per_sec)
+                } else {
+                    Duration::ZERO
+                };
+                byte_wait.max(op_wait)
+            };
+
+            if sleep_for.is_zero() {
+                return;
+            }
+            debug!("Throttle: pausing {:?} to repay token debt", sleep_for);
+            tokio::time::sleep(sleep_for).await;
+        }
+    }
+
+    /// Charge the bucket for work already done. `bytes` is the actual byte
+    /// count the strategy reported; `ops` approximates the I/O operations it
+    /// issued.
+    pub fn consume(&self, bytes: u64, ops: u64) {
+        let mut state = self.state.lock().unwrap();
+        self.refill(&mut state);
+        if self.bytes_per_sec > 0 {
+            state.byte_tokens -= bytes as i64;
+        }
+        if self.ops_per_sec > 0 {
+            state.op_tokens -= ops as i64;
+        }
+    }
+
+    /// Add tokens for the time elapsed since the last refill, capping the
+    /// surplus at one second of rate so idle periods can't bank an
+    /// arbitrarily large burst.
+    fn refill(&self, state: &mut BucketState) {
+        let now = Instant::now();
+        let elapsed = now.duration_since(state.last_refill);
+        state.last_refill = now;
+        if self.bytes_per_sec > 0 {
+            let earned = (elapsed.as_secs_f64() * self.bytes_per_sec as f64) as i64;
+            state.byte_tokens = (state.byte_tokens + earned).min(self.bytes_per_sec as i64);
+        }
+        if self.ops_per_sec > 0 {
+            let earned = (elapsed.as_secs_f64() * self.ops_per_sec as f64) as i64;
+            state.op_tokens = (state.op_tokens + earned).min(self.ops_per_sec as i64);
+        }
+    }
+
+    fn time_to_repay(debt: i64, rate: u64) -> Duration {
+        Duration::from_secs_f64(debt as f64 / rate as f64)
+    }
+}
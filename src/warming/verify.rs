@@ -0,0 +1,155 @@
+//! Post-warm verification: proof the volume is actually hydrated.
+//!
+//! `WarmingResult.success` is optimistic - the sparse loops log read errors
+//! and keep going, so a "successful" run can leave blocks still backed by
+//! S3. With `--verify`, after warming finishes we sample random offsets in
+//! every warmed file with timed O_DIRECT reads (uncached by construction,
+//! so each sample measures the volume, not the page cache). Samples are
+//! fed into a latency histogram for the report, and any file with a sample
+//! over the threshold is flagged cold so the caller can re-warm it: a cold
+//! EBS block is a round trip to S3 and sits orders of magnitude above a
+//! hydrated read.
+
+use std::path::PathBuf;
+use std::time::{Duration, Instant};
+
+use futures::stream::{self, StreamExt};
+use log::debug;
+
+use crate::warming::metrics::Histogram;
+
+/// Everything the report needs: the sample latency distribution plus the
+/// files whose samples say their blocks are still cold.
+pub struct VerifyOutcome {
+    pub files_sampled: usize,
+    pub latency: Histogram,
+    pub cold: Vec<(PathBuf, u64)>,
+}
+
+/// Sample every file with `samples_per_file` timed O_DIRECT reads, up to
+/// `concurrency` files in flight.
+#[cfg(target_os = "linux")]
+pub async fn verify_files(
+    files: &[(PathBuf, u64)],
+    samples_per_file: u32,
+    threshold: Duration,
+    concurrency: usize,
+) -> VerifyOutcome {
+    let results: Vec<_> = stream::iter(files.iter().cloned())
+        .map(|(path, size)| async move {
+            let probe_path = path.clone();
+            let latencies = tokio::task::spawn_blocking(move || {
+                sample_file(&probe_path, size, samples_per_file)
+            })
+            .await
+            .unwrap_or_default();
+            (path, size, latencies)
+        })
+        .buffer_unordered(concurrency.max(1))
+        .collect()
+        .await;
+
+    let mut latency = Histogram::default();
+    let mut cold = Vec::new();
+    let mut files_sampled = 0;
+    for (path, size, latencies) in results {
+        if latencies.is_empty() {
+            continue;
+        }
+        files_sampled += 1;
+        let mut is_cold = false;
+        for sample in &latencies {
+            latency.record(*sample);
+            if *sample > threshold {
+                is_cold = true;
+            }
+        }
+        if is_cold {
+            debug!("Verification found cold samples in {}", path.display());
+            cold.push((path, size));
+        }
+    }
+    VerifyOutcome { files_sampled, latency, cold }
+}
+
+/// Timed O_DIRECT reads at random aligned offsets. Returns one latency per
+/// sample that completed; open or read failures just end the file's samples
+/// (the warming pass already reported them).
+#[cfg(target_os = "linux")]
+fn sample_file(path: &PathBuf, file_size: u64, samples: u32) -> Vec<Duration> {
+    use std::os::unix::fs::OpenOptionsExt;
+    use std::os::unix::prelude::AsRawFd;
+
+    const SAMPLE_SIZE: usize = 4096;
+
+    if file_size == 0 {
+        return Vec::new();
+    }
+    let file = match std::fs::OpenOptions::new()
+        .read(true)
+        .custom_flags(libc::O_DIRECT)
+        .open(path)
+    {
+        Ok(file) => file,
+        Err(e) => {
+            debug!("Verification cannot open {}: {}", path.display(), e);
+            return Vec::new();
+        }
+    };
+    let buffer = match crate::warming::buffers::acquire(SAMPLE_SIZE) {
+        Ok(buffer) => buffer,
+        Err(e) => {
+            debug!("Verification cannot acquire a buffer: {}", e);
+            return Vec::new();
+        }
+    };
+
+    let fd = file.as_raw_fd();
+    let blocks = file_size.div_ceil(SAMPLE_SIZE as u64);
+    // xorshift instead of a rand dependency: offsets only need to be spread
+    // out, not unpredictable. Seeded per file so reruns vary.
+    let mut state = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .map(|d| d.as_nanos() as u64)
+        .unwrap_or(0)
+        ^ file_size
+        ^ 0x9E37_79B9_7F4A_7C15;
+    let mut latencies = Vec::with_capacity(samples as usize);
+    for _ in 0..samples.max(1) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        let offset = (state % blocks) * SAMPLE_SIZE as u64;
+        let start = Instant::now();
+        let rc = unsafe {
+            libc::pread(fd, buffer.as_mut_ptr().cast(), SAMPLE_SIZE, offset as libc::off_t)
+        };
+        if rc < 0 {
+            debug!(
+                "Verification read failed in {} at offset {}: {}",
+                path.display(),
+                offset,
+                std::io::Error::last_os_error()
+            );
+            break;
+        }
+        latencies.push(start.elapsed());
+    }
+    latencies
+}
+
+// Stub implementation for non-Linux systems: no O_DIRECT, so a timed read
+// would measure the page cache we just filled, not the volume.
+#[cfg(not(target_os = "linux"))]
+pub async fn verify_files(
+    _files: &[(PathBuf, u64)],
+    _samples_per_file: u32,
+    _threshold: Duration,
+    _concurrency: usize,
+) -> VerifyOutcome {
+    VerifyOutcome {
+        files_sampled: 0,
+        latency: Histogram::default(),
+        cold: Vec::new(),
+    }
+}